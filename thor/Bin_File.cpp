@@ -4,43 +4,50 @@
 #include "File.h"
 #include "Geo_File.h"
 #include "Graphics.h"
+#include "Map.h"
 #include "Memory.h"
+#include "Pigg_File.h"
 #include "String.h"
+#include "Thread.h"
+#include "Zlib.h"
 
 
 
-static void bin_file_read_string(File_Handle file, char* dst, uint32 dst_size) // todo(jbr) put dst then dst_size
+// bin files are parsed a field at a time, so they're read through a buffer rather than a syscall per field
+constexpr uint32 c_bin_file_reader_buffer_size = kilobytes(64);
+
+static void bin_file_read_string(File_Reader* reader, char* dst, uint32 dst_size) // todo(jbr) put dst then dst_size
 {
-	uint16 string_length = file_read_u16(file);
+	uint16 string_length = file_reader_read_u16(reader);
 	assert(string_length < dst_size);
 
-	file_read(file, string_length, dst);
+	file_reader_read(reader, string_length, dst);
 	dst[string_length] = 0;
 
 	// note: bin files need 4 byte aligned reads
 	uint32 bytes_misaligned = (string_length + 2) & 3; // & 3 is equivalent to % 4
 	if (bytes_misaligned)
 	{
-		file_skip(file, 4 - bytes_misaligned);
+		file_reader_skip(reader, 4 - bytes_misaligned);
 	}
 }
 
-static char* bin_file_read_string(File_Handle file, Linear_Allocator* allocator)
+static char* bin_file_read_string(File_Reader* reader, Linear_Allocator* allocator)
 {
-	uint16 string_length = file_read_u16(file);
+	uint16 string_length = file_reader_read_u16(reader);
 	
 	if (string_length)
 	{
 		char* str = (char*)linear_allocator_alloc(allocator, string_length + 1);
 
-		file_read(file, string_length, str);
+		file_reader_read(reader, string_length, str);
 		str[string_length] = 0;
 
 		// note: bin files need 4 byte aligned reads
 		uint32 bytes_misaligned = (string_length + 2) & 3; // & 3 is equivalent to % 4
 		if (bytes_misaligned)
 		{
-			file_skip(file, 4 - bytes_misaligned);
+			file_reader_skip(reader, 4 - bytes_misaligned);
 		}
 
 		return str;
@@ -49,170 +56,19 @@ static char* bin_file_read_string(File_Handle file, Linear_Allocator* allocator)
 	return nullptr;
 }
 
-static void bin_file_skip_string(File_Handle file)
+static void bin_file_skip_string(File_Reader* reader)
 {
-	uint16 string_length = file_read_u16(file);
-	file_skip(file, string_length);
+	uint16 string_length = file_reader_read_u16(reader);
+	file_reader_skip(reader, string_length);
 
 	// note: bin files need 4 byte aligned reads
 	uint32 bytes_misaligned = (string_length + 2) & 3; // & 3 is equivalent to % 4
 	if (bytes_misaligned)
 	{
-		file_skip(file, 4 - bytes_misaligned);
-	}
-}
-
-constexpr uint32 c_crc_32_generator = 0x04C11DB7;
-constexpr uint32 c_crc_32_init = 0xffffffff;
-constexpr uint32 c_crc_32_xor_out = 0xffffffff;
-static uint32 crc_32_slow(uint8* input, int32 input_size)
-{
-	uint32 crc = 0;
-
-	uint8* input_end = &input[input_size];
-	for (; input != input_end; ++input)
-	{
-		crc ^= (*input << 24);
-
-		for (int32 j = 0; j < 8; ++j)
-		{
-			if (crc & (1 << 31))
-			{
-				crc = (crc << 1) ^ c_crc_32_generator;
-			}
-			else
-			{
-				crc <<= 1;
-			}
-		}
-	}
-
-	return crc;
-} // todo(jbr) can we do the byte flipping thing by shifting the other direction?
-
-static uint32* crc_32_create_table()
-{
-	static uint32 table[256];
-
-	for (int32 i = 0; i < 256; ++i)
-	{
-		uint8 input = (uint8)i;
-		table[i] = crc_32_slow(&input, 1);
-	}
-
-	return table;
-}
-static uint32* s_crc_32_table = crc_32_create_table();
-
-/*static uint32 crc_32(uint8* input, int32 input_size)
-{
-	uint32 crc = c_crc_32_init;
-
-	uint8* input_end = &input[input_size];
-	for (; input != input_end; ++input)
-	{
-		crc ^= (*input << 24);
-		crc = (crc << 8) ^ s_crc_32_table[crc >> 24];
-	}
-
-	return crc ^ c_crc_32_xor_out;
-}*/
-
-static uint32 crc_32_ignore_case(uint8* input, int32 input_size)
-{
-	uint32 crc = c_crc_32_init;
-
-	uint8* input_end = &input[input_size];
-	for (; input != input_end; ++input)
-	{
-		crc ^= (char_to_lower(*input) << 24);
-		crc = (crc << 8) ^ s_crc_32_table[crc >> 24];
-	}
-
-	return crc ^ c_crc_32_xor_out;
-}
-
-struct Map
-{
-	struct Node
-	{
-		const char* key;
-		void* value;
-		Node* next;
-	};
-
-	Node* node_pool;
-	int32 node_pool_size;
-	Node* next_available_node;
-	Node* map;
-	int32 map_size;
-	int32 map_mask;
-};// todo(jbr) fib index thing
-
-static void map_create(Map* map, int32 max_items, Linear_Allocator* allocator)
-{
-	map->node_pool = (Map::Node*)linear_allocator_alloc(allocator, sizeof(Map::Node) * max_items);
-	map->node_pool_size = max_items;
-	map->next_available_node = map->node_pool;
-	map->map_size = u32_max(u32_round_down_power_of_two(max_items), 4);
-	map->map_mask = map->map_size - 1;
-	map->map = (Map::Node*)linear_allocator_alloc(allocator, sizeof(Map::Node) * map->map_size);
-	for (int32 i = 0; i < map->map_size; ++i)
-	{
-		map->map[i] = {};
+		file_reader_skip(reader, 4 - bytes_misaligned);
 	}
 }
 
-static void map_add(Map* map, const char* key, void* value)
-{
-	assert(key);
-
-	uint32 hash = crc_32_ignore_case((uint8*)key, string_length(key));
-
-	assert(map->next_available_node != (map->node_pool + map->node_pool_size));
-
-	Map::Node* node = &map->map[hash & map->map_mask];
-	if (!node->key)
-	{
-		node->key = key;
-		node->value = value;
-	}
-	else
-	{
-		Map::Node* new_node = map->next_available_node++;
-		new_node->key = node->key;
-		new_node->value = node->value;
-		new_node->next = node->next;
-		node->key = key;
-		node->value = value;
-		node->next = new_node;
-	}
-}
-
-static void* map_find(Map* map, const char* key)
-{
-	assert(key);
-
-	uint32 hash = crc_32_ignore_case((uint8*)key, string_length(key));
-	Map::Node* node = &map->map[hash & map->map_mask];
-	
-	if (node->key)
-	{
-		do
-		{
-			if (string_equals_ignore_case(node->key, key))
-			{
-				return node->value;
-			}
-
-			node = node->next;
-		}
-		while (node);
-	}
-
-	return nullptr;
-}
-
 struct Group
 {
 	const char* name;
@@ -239,39 +95,80 @@ struct Geobin
 	Geobin* next;
 };
 
-static void bin_file_read_header(File_Handle file, uint32 expected_type_id)
+// bins come out of the mount when there is one and it has them, otherwise they're opened loose from data_path, which 
+// is the data directory with a trailing slash. Returns false if the bin can't be found or read in either, once done 
+// with the reader it's closed with bin_file_reader_close
+static bool32 bin_file_reader_open(File_Reader* out_reader, uint8* reader_buffer, const char* relative_file_path, const char* data_path, Pigg_Mount* mount, Linear_Allocator* allocator)
+{
+	if (mount)
+	{
+		uint32 size;
+		uint8* bytes = pigg_mount_read(mount, relative_file_path, allocator, &size);
+		if (bytes)
+		{
+			file_reader_create_from_memory(out_reader, bytes, size);
+			return true;
+		}
+	}
+
+	char file_path[256];
+	string_concat(file_path, sizeof(file_path), data_path, relative_file_path);
+
+	File_Handle file = file_open_read(file_path);
+	if (!file_is_valid(file))
+	{
+		return false;
+	}
+
+	file_reader_create(out_reader, file, reader_buffer, c_bin_file_reader_buffer_size);
+
+	// the whole file gets parsed, so have the OS read ahead of the parser
+	file_prefetch(file, 0, out_reader->file_size);
+
+	return true;
+}
+
+static void bin_file_reader_close(File_Reader* reader)
+{
+	if (reader->file)
+	{
+		file_close(reader->file);
+	}
+}
+
+static void bin_file_read_header(File_Reader* reader, uint32 expected_type_id)
 {
 	uint8 sig[8];
-	file_read(file, 8, sig);
+	file_reader_read(reader, 8, sig);
 	assert(bytes_equal(sig, c_bin_file_sig, 8));
 
-	uint32 bin_type_id = file_read_u32(file);
+	uint32 bin_type_id = file_reader_read_u32(reader);
 	assert(bin_type_id == expected_type_id);
 
 	{
 		char buffer[8];
-		bin_file_read_string(file, buffer, sizeof(buffer));
+		bin_file_read_string(reader, buffer, sizeof(buffer));
 		assert(string_equals(buffer, "Parse6"));
-		bin_file_read_string(file, buffer, sizeof(buffer));
+		bin_file_read_string(reader, buffer, sizeof(buffer));
 		assert(string_equals(buffer, "Files1"));
 	}
 
-	uint32 files_section_size = file_read_u32(file);
-	file_skip(file, files_section_size);
+	uint32 files_section_size = file_reader_read_u32(reader);
+	file_reader_skip(reader, files_section_size);
 
-	file_skip(file, 4); // data size
+	file_reader_skip(reader, 4); // data size
 }
 
-static void geobin_file_read_single(File_Handle file, Geobin* out_geobin, const char* relative_geobin_file_path, Linear_Allocator* allocator)
+static void geobin_file_read_single(File_Reader* reader, Geobin* out_geobin, const char* relative_geobin_file_path, Linear_Allocator* allocator)
 {
-	bin_file_read_header(file, c_bin_geobin_type_id);
+	bin_file_read_header(reader, c_bin_geobin_type_id);
 
-	file_skip(file, 4); // int32 version
+	file_reader_skip(reader, 4); // int32 version
 
-	bin_file_skip_string(file); // scene file
-	bin_file_skip_string(file); // loading screen
+	bin_file_skip_string(reader); // scene file
+	bin_file_skip_string(reader); // loading screen
 
-	int32 def_count = file_read_i32(file);
+	int32 def_count = file_reader_read_i32(reader);
 	Def* defs = def_count ? (Def*)linear_allocator_alloc(allocator, sizeof(Def) * def_count) : nullptr;
 
 	Map def_map = {};
@@ -284,12 +181,12 @@ static void geobin_file_read_single(File_Handle file, Geobin* out_geobin, const
 	{
 		Def* def = &defs[def_i];
 
-		uint32 def_size = file_read_u32(file);
-		uint32 def_start = file_get_position(file);
+		uint32 def_size = file_reader_read_u32(reader);
+		uint64 def_start = file_reader_get_position(reader);
 
-		def->name = bin_file_read_string(file, allocator);;
+		def->name = bin_file_read_string(reader, allocator);;
 		
-		int32 group_count = file_read_i32(file);
+		int32 group_count = file_reader_read_i32(reader);
 
 		def->group_count = group_count;
 		def->groups = group_count ? (Group*)linear_allocator_alloc(allocator, sizeof(Group) * group_count) : nullptr;
@@ -298,51 +195,51 @@ static void geobin_file_read_single(File_Handle file, Geobin* out_geobin, const
 		{
 			Group* group = &def->groups[group_i];
 
-			file_skip(file, 4); // size
+			file_reader_skip(reader, 4); // size
 
-			group->name = bin_file_read_string(file, allocator);
-			group->position = file_read_vec_3f(file);
-			Vec_3f euler_degrees = file_read_vec_3f(file);
+			group->name = bin_file_read_string(reader, allocator);
+			group->position = file_reader_read_vec_3f(reader);
+			Vec_3f euler_degrees = file_reader_read_vec_3f(reader);
 			Vec_3f euler = vec_3f_mul(euler_degrees, c_deg_to_rad);
 			group->rotation = quat_euler(euler);
 
-			file_skip(file, 4); // flags
+			file_reader_skip(reader, 4); // flags
 		}
 
 		// 11 sections here we don't (yet) care about
 		for (int32 skip_i = 0; skip_i < 11; ++skip_i)
 		{
-			int32 count = file_read_i32(file);
+			int32 count = file_reader_read_i32(reader);
 			for (int32 i = 0; i < count; ++i)
 			{
-				uint32 size = file_read_u32(file);
-				file_skip(file, size);
+				uint32 size = file_reader_read_u32(reader);
+				file_reader_skip(reader, size);
 			}
 		}
 
-		bin_file_skip_string(file); // "Type"
-		file_skip(file, 4); // uint32 flags
-		file_skip(file, 4); // float32 alpha
+		bin_file_skip_string(reader); // "Type"
+		file_reader_skip(reader, 4); // uint32 flags
+		file_reader_skip(reader, 4); // float32 alpha
 
-		def->obj = bin_file_read_string(file, allocator);
+		def->obj = bin_file_read_string(reader, allocator);
 
 		map_add(&def_map, def->name, def);
 
-		file_set_position(file, def_start + def_size);
+		file_reader_set_position(reader, def_start + def_size);
 	}
 
-	int32 ref_count = file_read_i32(file);
+	int32 ref_count = file_reader_read_i32(reader);
 	Group* refs = ref_count ? (Group*)linear_allocator_alloc(allocator, sizeof(Group) * ref_count) : nullptr;
 
 	for (int32 ref_i = 0; ref_i < ref_count; ++ref_i)
 	{
 		Group* ref = &refs[ref_i];
 
-		file_skip(file, 4); // size
+		file_reader_skip(reader, 4); // size
 
-		ref->name = bin_file_read_string(file, allocator);
-		ref->position = file_read_vec_3f(file);
-		Vec_3f euler_degrees = file_read_vec_3f(file);
+		ref->name = bin_file_read_string(reader, allocator);
+		ref->position = file_reader_read_vec_3f(reader);
+		Vec_3f euler_degrees = file_reader_read_vec_3f(reader);
 		Vec_3f euler = vec_3f_mul(euler_degrees, c_deg_to_rad);
 		ref->rotation = quat_euler(euler);
 	}
@@ -378,36 +275,36 @@ struct Defnames
 	Map row_map;
 };
 
-static void defnames_file_read(File_Handle file, Defnames* out_defnames, Linear_Allocator* allocator)
+static void defnames_file_read(File_Reader* reader, Defnames* out_defnames, Linear_Allocator* allocator)
 {
-	bin_file_read_header(file, c_bin_defnames_type_id);
+	bin_file_read_header(reader, c_bin_defnames_type_id);
 
 	*out_defnames = {};
-	out_defnames->relative_file_path_count = file_read_i32(file);
+	out_defnames->relative_file_path_count = file_reader_read_i32(reader);
 	out_defnames->relative_file_paths = (const char**)linear_allocator_alloc(allocator, sizeof(const char*) * out_defnames->relative_file_path_count);
 	const char** relative_file_path_end = &out_defnames->relative_file_paths[out_defnames->relative_file_path_count];
 	for (const char** relative_file_path = out_defnames->relative_file_paths; relative_file_path != relative_file_path_end; ++relative_file_path)
 	{
-		file_skip(file, 4); // size
+		file_reader_skip(reader, 4); // size
 
-		*relative_file_path = bin_file_read_string(file, allocator);
+		*relative_file_path = bin_file_read_string(reader, allocator);
 	}
 
-	out_defnames->row_count = file_read_i32(file);
+	out_defnames->row_count = file_reader_read_i32(reader);
 	out_defnames->rows = (Defnames::Row*)linear_allocator_alloc(allocator, sizeof(Defnames::Row) * out_defnames->row_count);
 	map_create(&out_defnames->row_map, /*max_items*/ out_defnames->row_count, allocator);
 
 	Defnames::Row* row_end = &out_defnames->rows[out_defnames->row_count];
 	for (Defnames::Row* row = out_defnames->rows; row != row_end; ++row)
 	{
-		file_skip(file, 4); // size
+		file_reader_skip(reader, 4); // size
 
-		row->defname = bin_file_read_string(file, allocator);
+		row->defname = bin_file_read_string(reader, allocator);
 		
-		uint16 index = file_read_u16(file);
+		uint16 index = file_reader_read_u16(reader);
 		row->relative_file_path = out_defnames->relative_file_paths[index];
 
-		row->is_geo = file_read_u16(file);
+		row->is_geo = file_reader_read_u16(reader);
 		
 		map_add(&out_defnames->row_map, row->defname, row);
 	}
@@ -430,6 +327,7 @@ struct Geo_Model
 struct Geo
 {
 	const char* relative_file_path;
+	Pigg_Mount_File* mount_file; // set when the geo is opened, if it's in the mount
 	Geo_Model* models;
 	Geo* next;
 };
@@ -489,7 +387,28 @@ static void add_model_instance(const char* relative_geo_file_path, const char* m
 	model->instances = model_instance;
 }
 
-static void recursively_find_models(Geobin* geobin, Def* def, Vec_3f def_position, Quat def_rotation, Defnames* defnames, Geobin* geobins, Geo** geos, const char* geobin_base_path, Linear_Allocator* allocator)
+// kept out of recursively_find_models so the reader buffer isn't on the stack at every level of the recursion, 
+// returns null if the geobin can't be found or read
+static Geobin* geobin_file_read_referenced(const char* relative_geobin_file_path, const char* data_path, Pigg_Mount* mount, Linear_Allocator* allocator)
+{
+	char geobin_file_path[256];
+	string_concat(geobin_file_path, sizeof(geobin_file_path), "geobin/", relative_geobin_file_path);
+
+	uint8 reader_buffer[c_bin_file_reader_buffer_size];
+	File_Reader reader;
+	if (!bin_file_reader_open(&reader, reader_buffer, geobin_file_path, data_path, mount, allocator))
+	{
+		return nullptr;
+	}
+
+	Geobin* geobin = (Geobin*)linear_allocator_alloc(allocator, sizeof(Geobin));
+	geobin_file_read_single(&reader, geobin, relative_geobin_file_path, allocator);
+	bin_file_reader_close(&reader);
+
+	return geobin;
+}
+
+static void recursively_find_models(Geobin* geobin, Def* def, Vec_3f def_position, Quat def_rotation, Defnames* defnames, Geobin* geobins, Geo** geos, const char* data_path, Pigg_Mount* mount, Linear_Allocator* allocator)
 {
 	if (def->obj)
 	{
@@ -530,7 +449,7 @@ static void recursively_find_models(Geobin* geobin, Def* def, Vec_3f def_positio
 			referenced_def = (Def*)map_find(&geobin->def_map, def_name);
 			if (referenced_def)
 			{
-				recursively_find_models(geobin, referenced_def, world_position, world_rotation, defnames, geobins, geos, geobin_base_path, allocator);
+				recursively_find_models(geobin, referenced_def, world_position, world_rotation, defnames, geobins, geos, data_path, mount, allocator);
 			}
 		}
 
@@ -568,53 +487,95 @@ static void recursively_find_models(Geobin* geobin, Def* def, Vec_3f def_positio
 
 					if (!referenced_geobin)
 					{
-						char referenced_geobin_file_path[256];
-						string_concat(referenced_geobin_file_path, sizeof(referenced_geobin_file_path), geobin_base_path, relative_geobin_file_path);
-
-						File_Handle referenced_geobin_file = file_open_read(referenced_geobin_file_path);
-
-						referenced_geobin = (Geobin*)linear_allocator_alloc(allocator, sizeof(Geobin));
-						geobin_file_read_single(referenced_geobin_file, referenced_geobin, relative_geobin_file_path, allocator);
+						referenced_geobin = geobin_file_read_referenced(relative_geobin_file_path, data_path, mount, allocator);
+						if (!referenced_geobin)
+						{
+							// a missing geobin leaves out this group, rather than the whole map
+							assert(false);
+							continue;
+						}
 
 						referenced_geobin->next = geobins->next;
 						geobins->next = referenced_geobin;
 					}
 
-					assert(referenced_geobin);
-
 					referenced_def = (Def*)map_find(&referenced_geobin->def_map, def_name);
 					assert(referenced_def);
 
-					recursively_find_models(referenced_geobin, referenced_def, world_position, world_rotation, defnames, geobins, geos, geobin_base_path, allocator);
+					recursively_find_models(referenced_geobin, referenced_def, world_position, world_rotation, defnames, geobins, geos, data_path, mount, allocator);
 				}
 			}
 		}
 	}
 }
 
+// geo headers are compressed and the size isn't known until it's read, but they're rarely bigger than this
+constexpr uint32 c_geo_header_prefetch_size = kilobytes(64);
+
+// geos in the mount are read out of the pigg, so that just gets the hint (and nothing is opened), otherwise the 
+// loose geo is opened
+static File_Handle geo_file_open_with_prefetch(const char* data_path, Pigg_Mount* mount, Geo* geo)
+{
+	geo->mount_file = mount ? pigg_mount_find(mount, geo->relative_file_path) : nullptr;
+	if (geo->mount_file)
+	{
+		pigg_prefetch(geo->mount_file->archive, geo->mount_file->entry, c_geo_header_prefetch_size);
+		return nullptr;
+	}
+
+	char geo_file_path[256];
+	string_concat(geo_file_path, sizeof(geo_file_path), data_path, geo->relative_file_path);
+
+	File_Handle geo_file = file_open_read(geo_file_path);
+	if (file_is_valid(geo_file))
+	{
+		file_prefetch(geo_file, 0, c_geo_header_prefetch_size);
+	}
+
+	return geo_file;
+}
+
 void geobin_file_read(
-	File_Handle file, 
 	const char* relative_geobin_file_path, 
 	const char* coh_data_path, 
+	Pigg_Mount* mount, 
 	int32* out_model_count, 
 	Model** out_models, 
 	int32** out_model_instance_count, 
 	Transform*** out_model_instances, 
+	Thread_Pool* thread_pool, 
 	struct Linear_Allocator* allocator,
 	Linear_Allocator* temp_allocator)
 {
-	char defnames_file_path[256];
-	string_concat(defnames_file_path, sizeof(defnames_file_path), coh_data_path, "/bin/defnames.bin");
-	File_Handle defnames_file = file_open_read(defnames_file_path);
+	*out_model_count = 0;
+	*out_models = nullptr;
+	*out_model_instance_count = nullptr;
+	*out_model_instances = nullptr;
+
+	char data_path[256];
+	string_concat(data_path, sizeof(data_path), coh_data_path, "/");
+
+	uint8 reader_buffer[c_bin_file_reader_buffer_size];
+	File_Reader reader;
+
+	if (!bin_file_reader_open(&reader, reader_buffer, "bin/defnames.bin", data_path, mount, temp_allocator))
+	{
+		return;
+	}
 	Defnames* defnames = (Defnames*)linear_allocator_alloc(temp_allocator, sizeof(Defnames));
-	defnames_file_read(defnames_file, defnames, temp_allocator);
-	file_close(defnames_file);
+	defnames_file_read(&reader, defnames, temp_allocator);
+	bin_file_reader_close(&reader);
 
-	char geobin_base_path[256];
-	string_concat(geobin_base_path, sizeof(geobin_base_path), coh_data_path, "/geobin/");
+	char root_geobin_file_path[256];
+	string_concat(root_geobin_file_path, sizeof(root_geobin_file_path), "geobin/", relative_geobin_file_path);
 
+	if (!bin_file_reader_open(&reader, reader_buffer, root_geobin_file_path, data_path, mount, temp_allocator))
+	{
+		return;
+	}
 	Geobin* root_geobin = (Geobin*)linear_allocator_alloc(temp_allocator, sizeof(Geobin));
-	geobin_file_read_single(file, root_geobin, relative_geobin_file_path, temp_allocator);
+	geobin_file_read_single(&reader, root_geobin, relative_geobin_file_path, temp_allocator);
+	bin_file_reader_close(&reader);
 
 	Geo* geos = nullptr;
 
@@ -627,12 +588,9 @@ void geobin_file_read(
 		Def* def = (Def*)map_find(&root_geobin->def_map, ref->name);
 		assert(def);
 
-		recursively_find_models(root_geobin, def, ref->position, ref->rotation, defnames, root_geobin, &geos, geobin_base_path, temp_allocator);
+		recursively_find_models(root_geobin, def, ref->position, ref->rotation, defnames, root_geobin, &geos, data_path, mount, temp_allocator);
 	}
 
-	char geo_base_path[256];
-	string_concat(geo_base_path, sizeof(geo_base_path), coh_data_path, "/");
-
 	int32 total_model_count = 0;
 	Geo* geo = geos;
 	while (geo)
@@ -657,9 +615,30 @@ void geobin_file_read(
 	int32* current_model_instance_count = model_instance_count;
 	Transform** current_model_instances = model_instances;
 	
+	// reader threads mostly sit waiting on the disk, so there can be more than there are cores
+	File_Read_Queue read_queue;
+	file_read_queue_create(&read_queue, /*thread_count*/ 8, /*capacity*/ 1024, temp_allocator);
+
+	// an inflate context per worker for every geo, rather than zlib setting itself up again for each one
+	int32 inflate_context_count = thread_pool ? thread_pool->worker_count : 1;
+	Zlib_Inflate_Context* inflate_contexts = (Zlib_Inflate_Context*)linear_allocator_alloc(temp_allocator, sizeof(Zlib_Inflate_Context) * inflate_context_count);
+	for (int32 i = 0; i < inflate_context_count; ++i)
+	{
+		zlib_inflate_context_create(&inflate_contexts[i], temp_allocator);
+	}
+
+	File_Handle next_geo_file = geos ? geo_file_open_with_prefetch(data_path, mount, geos) : nullptr;
+
 	geo = geos;
 	while (geo)
 	{
+		// open the next geo now and hint its header, so it's on its way in while this one is decoded
+		File_Handle geo_file = next_geo_file;
+		if (geo->next)
+		{
+			next_geo_file = geo_file_open_with_prefetch(data_path, mount, geo->next);
+		}
+
 		// reset the geo temp allocator for each file
 		Linear_Allocator geo_temp_allocator = *temp_allocator;
 
@@ -682,14 +661,41 @@ void geobin_file_read(
 			geo_model = geo_model->next;
 		}
 
-		// read models from geo file
-		char geo_file_path[256];
-		string_concat(geo_file_path, sizeof(geo_file_path), geo_base_path, geo->relative_file_path);
+		// a geo in the mount is read straight out of the pigg, stored ones without copying them
+		Geo_Source geo_source = {};
+		bool32 is_geo_found = false;
+		if (geo->mount_file)
+		{
+			const uint8* geo_bytes = pigg_read_mapped(geo->mount_file->archive, geo->mount_file->entry, &geo_temp_allocator);
+			if (geo_bytes)
+			{
+				geo_source_create_from_memory(&geo_source, geo_bytes, geo->mount_file->entry->file_size);
+				is_geo_found = true;
+			}
+		}
+		else if (file_is_valid(geo_file))
+		{
+			geo_source_create(&geo_source, geo_file);
+			is_geo_found = true;
+		}
+
+		// read models from geo file, if it's corrupt its models (and their instances) are left out, and the next 
+		// geo's models go in their place
+		bool32 is_geo_read = is_geo_found && 
+			geo_file_read(&geo_source, /*header*/ nullptr, model_names, current_model, model_count, /*flags*/ 0, /*lod_distances*/ nullptr, &read_queue, thread_pool, inflate_contexts, allocator, &geo_temp_allocator);
+		if (!geo->mount_file && file_is_valid(geo_file))
+		{
+			file_close(geo_file);
+		}
+
+		if (!is_geo_read)
+		{
+			total_model_count -= model_count;
+			geo = geo->next;
+			continue;
+		}
 
-		File_Handle geo_file = file_open_read(geo_file_path);
-		geo_file_read(geo_file, model_names, current_model, model_count, allocator, &geo_temp_allocator);
 		current_model += model_count;
-		file_close(geo_file);
 		
 		// convert instance position/rotation 
 		geo_model = geo->models;
@@ -727,6 +733,8 @@ void geobin_file_read(
 		geo = geo->next;
 	}
 
+	file_read_queue_destroy(&read_queue);
+
 	*out_model_count = total_model_count;
 	*out_models = models;
 	*out_model_instance_count = model_instance_count;
@@ -11,13 +11,16 @@ constexpr uint32 c_bin_defnames_type_id = 0x0c027625;
 
 
 
+// defnames, geobins and geos are read out of mount when it's given and has them, otherwise from the loose files 
+// under coh_data_path, the model arrays are left null if defnames or the geobin itself can't be found
 void geobin_file_read(
-	File_Handle file, 
 	const char* relative_geobin_file_path, 
 	const char* coh_data_path, 
+	struct Pigg_Mount* mount, 
 	int32* out_model_count, 
 	struct Model** out_models, 
 	int32** out_model_instance_count, 
 	Transform*** out_model_instances, 
+	struct Thread_Pool* thread_pool, 
 	struct Linear_Allocator* allocator,
 	Linear_Allocator* temp_allocator);
\ No newline at end of file
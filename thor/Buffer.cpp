@@ -120,4 +120,93 @@ void buffer_skip(uint8** inout_buffer, uint32 byte_count)
 	uint8* buffer = *inout_buffer;
 	buffer += byte_count;
 	*inout_buffer = buffer;
+}
+
+void buffer_write_u32(uint8** inout_buffer, uint32 u32)
+{
+	uint8* buffer = *inout_buffer;
+	*(uint32*)buffer = u32;
+
+	buffer += sizeof(uint32);
+	*inout_buffer = buffer;
+}
+
+void buffer_write_u16(uint8** inout_buffer, uint16 u16)
+{
+	uint8* buffer = *inout_buffer;
+	*(uint16*)buffer = u16;
+
+	buffer += sizeof(uint16);
+	*inout_buffer = buffer;
+}
+
+void buffer_write_bytes(uint8** inout_buffer, uint32 byte_count, const uint8* bytes)
+{
+	uint8* dst = *inout_buffer;
+	const uint8* src = bytes;
+	const uint8* end = src + byte_count;
+
+	for (; src != end; ++src, ++dst)
+	{
+		*dst = *src;
+	}
+
+	*inout_buffer = dst;
+}
+
+void buffer_reader_create(Buffer_Reader* out_reader, const uint8* bytes, uint32 size)
+{
+	*out_reader = {};
+	out_reader->bytes = bytes;
+	out_reader->size = size;
+}
+
+// returns a pointer to the next byte_count bytes and moves past them, or null (and sets is_overrun) if there 
+// aren't that many left
+const uint8* buffer_reader_read_bytes(Buffer_Reader* reader, uint32 byte_count)
+{
+	if (byte_count <= reader->size - reader->position)
+	{
+		const uint8* bytes = &reader->bytes[reader->position];
+		reader->position += byte_count;
+		return bytes;
+	}
+
+	reader->position = reader->size;
+	reader->is_overrun = true;
+	return nullptr;
+}
+
+uint32 buffer_reader_read_u32(Buffer_Reader* reader)
+{
+	const uint8* bytes = buffer_reader_read_bytes(reader, sizeof(uint32));
+	return bytes ? *(uint32*)bytes : 0;
+}
+
+uint16 buffer_reader_read_u16(Buffer_Reader* reader)
+{
+	const uint8* bytes = buffer_reader_read_bytes(reader, sizeof(uint16));
+	return bytes ? *(uint16*)bytes : 0;
+}
+
+uint8 buffer_reader_read_u8(Buffer_Reader* reader)
+{
+	const uint8* bytes = buffer_reader_read_bytes(reader, sizeof(uint8));
+	return bytes ? *bytes : 0;
+}
+
+int32 buffer_reader_read_i32(Buffer_Reader* reader)
+{
+	const uint8* bytes = buffer_reader_read_bytes(reader, sizeof(int32));
+	return bytes ? *(int32*)bytes : 0;
+}
+
+void buffer_reader_skip(Buffer_Reader* reader, uint32 byte_count)
+{
+	buffer_reader_read_bytes(reader, byte_count);
+}
+
+uint32 buffer_reader_bytes_remaining(Buffer_Reader* reader)
+{
+	return reader->size - reader->position;
 }
\ No newline at end of file
@@ -5,6 +5,17 @@
 
 
 
+// bounds checked reads from memory, for data which might be corrupt. A read past the end gives 0 and sets 
+// is_overrun, which stays set, so a run of reads only needs checking once at the end
+struct Buffer_Reader
+{
+	const uint8* bytes;
+	uint32 size;
+	uint32 position;
+	bool32 is_overrun;
+};
+
+
 uint32 buffer_read_u32(uint8** inout_buffer);
 uint16 buffer_read_u16(uint8** inout_buffer);
 uint8 buffer_read_u8(uint8** inout_buffer);
@@ -13,4 +24,15 @@ float32 buffer_read_f32(uint8** inout_buffer);
 Vec_3f buffer_read_vec_3f(uint8** inout_buffer);
 void buffer_read_bytes(uint8** inout_buffer, uint32 byte_count, uint8* out_bytes);
 void buffer_read_string(uint8** inout_buffer, char* out_string, uint32 max_chars /*incl null*/);
-void buffer_skip(uint8** inout_buffer, uint32 byte_count);
\ No newline at end of file
+void buffer_skip(uint8** inout_buffer, uint32 byte_count);
+void buffer_write_u32(uint8** inout_buffer, uint32 u32);
+void buffer_write_u16(uint8** inout_buffer, uint16 u16);
+void buffer_write_bytes(uint8** inout_buffer, uint32 byte_count, const uint8* bytes);
+void buffer_reader_create(Buffer_Reader* out_reader, const uint8* bytes, uint32 size);
+uint32 buffer_reader_read_u32(Buffer_Reader* reader);
+uint16 buffer_reader_read_u16(Buffer_Reader* reader);
+uint8 buffer_reader_read_u8(Buffer_Reader* reader);
+int32 buffer_reader_read_i32(Buffer_Reader* reader);
+const uint8* buffer_reader_read_bytes(Buffer_Reader* reader, uint32 byte_count);
+void buffer_reader_skip(Buffer_Reader* reader, uint32 byte_count);
+uint32 buffer_reader_bytes_remaining(Buffer_Reader* reader);
\ No newline at end of file
@@ -16,6 +16,12 @@ typedef int64_t int64;
 typedef float float32;
 
 
+#ifndef _MSC_VER
+#define __debugbreak() __builtin_trap()
+#define __forceinline inline __attribute__((always_inline))
+#endif // _MSC_VER
+
+
 #if _DEBUG
 #define assert(x) if(!(x)) {__debugbreak();}
 #else
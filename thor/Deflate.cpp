@@ -0,0 +1,942 @@
+#include "Deflate.h"
+
+#include "Memory.h"
+#include "zlib/zlib.h"
+
+
+
+// whole buffer deflate, producing a zlib stream. Matches are found with hash chains the same way zlib does,
+// symbols are collected a block at a time, then each block is written with whichever of stored, fixed or
+// dynamic huffman codes comes out smallest
+
+constexpr uint32 c_deflate_window_size = 32768;
+constexpr uint32 c_deflate_min_match = 3;
+constexpr uint32 c_deflate_max_match = 258;
+constexpr uint32 c_deflate_too_far = 4096; // a 3 byte match further back than this costs more than the literals
+constexpr uint32 c_deflate_max_hash_bits = 15;
+constexpr uint32 c_deflate_prev_size = 65536; // bigger than the window, so chains never run into overwritten positions
+constexpr uint32 c_deflate_no_position = 0xffffffff;
+constexpr uint32 c_deflate_block_symbol_count = 16384;
+constexpr uint32 c_deflate_max_stored_size = 65535;
+
+constexpr uint32 c_litlen_symbol_count = 288;
+constexpr uint32 c_dist_symbol_count = 30;
+constexpr uint32 c_precode_symbol_count = 19;
+constexpr uint32 c_end_of_block = 256;
+constexpr uint32 c_max_code_length = 15;
+constexpr uint32 c_max_precode_length = 7;
+
+static const uint16 c_length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8 c_length_extra_bits[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16 c_dist_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8 c_dist_extra_bits[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+static const uint8 c_precode_order[c_precode_symbol_count] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+// same meaning as zlib's configuration_table
+struct Deflate_Level_Config
+{
+	uint32 good_length; // once the previous match is this long, only search a quarter of the chain
+	uint32 lazy_length; // for lazy levels, don't try the next byte when the match is at least this long, 0 for greedy levels
+	uint32 max_insert_length; // for greedy levels, positions inside matches longer than this aren't added to the hash chains
+	uint32 nice_length; // stop searching when a match is at least this long
+	uint32 max_chain; // most candidates to look at for each position
+};
+
+static const Deflate_Level_Config c_deflate_level_configs[10] =
+{
+	{ 0, 0, 0, 0, 0 }, // stored
+	{ 4, 0, 4, 8, 4 }, // fastest, greedy
+	{ 4, 0, 5, 16, 8 },
+	{ 4, 0, 6, 32, 32 },
+	{ 4, 4, 0, 16, 16 }, // lazy from here on
+	{ 8, 16, 0, 32, 32 },
+	{ 8, 16, 0, 128, 128 }, // default
+	{ 8, 32, 0, 128, 256 },
+	{ 32, 128, 0, 258, 1024 },
+	{ 32, 258, 0, 258, 4096 }, // best
+};
+
+struct Deflate_Symbol
+{
+	uint16 literal_or_length;
+	uint16 distance; // 0 for a literal
+};
+
+struct Deflate_Bits
+{
+	uint64 bit_buffer;
+	uint32 bit_count;
+	uint8* out;
+	uint8* out_end;
+	bool32 is_out_of_space;
+};
+
+struct Deflate_Code
+{
+	uint16 codes[c_litlen_symbol_count]; // bit reversed, ready to write lsb first
+	uint8 lengths[c_litlen_symbol_count];
+};
+
+struct Deflate_State
+{
+	const uint8* bytes;
+	uint32 bytes_size;
+	const Deflate_Level_Config* config;
+	Deflate_Bits bits;
+
+	// hash chains
+	uint32* head; // most recent position for each hash
+	uint32* prev; // previous position with the same hash, indexed by position % c_deflate_prev_size
+	uint32 hash_bits;
+	uint32 next_insert_position;
+
+	// current block
+	Deflate_Symbol* symbols;
+	uint32 symbol_count;
+	uint32 litlen_counts[c_litlen_symbol_count];
+	uint32 dist_counts[c_dist_symbol_count];
+	uint32 block_start;
+	uint32 block_end;
+};
+
+
+static uint8* create_length_to_code_table()
+{
+	static uint8 table[c_deflate_max_match + 1];
+
+	for (uint32 code = 0; code < 29; ++code)
+	{
+		uint32 end = code < 28 ? c_length_base[code + 1] : c_deflate_max_match + 1;
+		for (uint32 length = c_length_base[code]; length < end; ++length)
+		{
+			table[length] = (uint8)code;
+		}
+	}
+	table[c_deflate_max_match] = 28; // 258 has its own code, rather than being 227 + 31
+
+	return table;
+}
+
+// distances up to 256 are looked up directly, beyond that codes cover multiples of 128
+static uint8* create_dist_to_code_table()
+{
+	static uint8 table[512];
+
+	for (uint32 code = 0; code < c_dist_symbol_count; ++code)
+	{
+		uint32 end = code < c_dist_symbol_count - 1 ? c_dist_base[code + 1] : c_deflate_window_size + 1;
+		for (uint32 dist = c_dist_base[code]; dist < end; ++dist)
+		{
+			if (dist <= 256)
+			{
+				table[dist] = (uint8)code;
+			}
+			else
+			{
+				table[256 + ((dist - 1) >> 7)] = (uint8)code;
+			}
+		}
+	}
+
+	return table;
+}
+
+static uint8* s_length_to_code_table = create_length_to_code_table();
+static uint8* s_dist_to_code_table = create_dist_to_code_table();
+
+static __forceinline uint32 deflate_dist_code(uint32 dist)
+{
+	return dist <= 256 ? s_dist_to_code_table[dist] : s_dist_to_code_table[256 + ((dist - 1) >> 7)];
+}
+
+static __forceinline void deflate_write_bits(Deflate_Bits* bits, uint32 value, uint32 bit_count)
+{
+	bits->bit_buffer |= (uint64)value << bits->bit_count;
+	bits->bit_count += bit_count;
+
+	if (bits->bit_count >= 32)
+	{
+		if (bits->out_end - bits->out >= 4)
+		{
+			*(uint32*)bits->out = (uint32)bits->bit_buffer;
+			bits->out += 4;
+		}
+		else
+		{
+			bits->is_out_of_space = true;
+		}
+
+		bits->bit_buffer >>= 32;
+		bits->bit_count -= 32;
+	}
+}
+
+// writes out any bits left over, padded with zeros to a whole byte
+static void deflate_flush_bits(Deflate_Bits* bits)
+{
+	while (bits->bit_count)
+	{
+		if (bits->out != bits->out_end)
+		{
+			*bits->out++ = (uint8)bits->bit_buffer;
+		}
+		else
+		{
+			bits->is_out_of_space = true;
+		}
+
+		bits->bit_buffer >>= 8;
+		bits->bit_count = bits->bit_count > 8 ? bits->bit_count - 8 : 0;
+	}
+}
+
+// huffman code lengths for the given symbol counts, no longer than max_length. Uses Moffat & Katajainen's
+// in place minimum redundancy algorithm, then moves any codes which are too long up to max_length the same
+// way miniz does
+static void deflate_build_code_lengths(const uint32* counts, uint32 symbol_count, uint32 max_length, uint8* out_lengths)
+{
+	uint32 sorted_counts[c_litlen_symbol_count];
+	uint16 sorted_symbols[c_litlen_symbol_count];
+	uint32 used_count = 0;
+
+	for (uint32 symbol = 0; symbol < symbol_count; ++symbol)
+	{
+		out_lengths[symbol] = 0;
+
+		uint32 count = counts[symbol];
+		if (!count)
+		{
+			continue;
+		}
+
+		// insertion sort, there are at most a few hundred symbols
+		uint32 i = used_count++;
+		while (i > 0 && sorted_counts[i - 1] > count)
+		{
+			sorted_counts[i] = sorted_counts[i - 1];
+			sorted_symbols[i] = sorted_symbols[i - 1];
+			--i;
+		}
+		sorted_counts[i] = count;
+		sorted_symbols[i] = (uint16)symbol;
+	}
+
+	if (used_count == 0)
+	{
+		return;
+	}
+
+	if (used_count == 1)
+	{
+		out_lengths[sorted_symbols[0]] = 1;
+		return;
+	}
+
+	// turns sorted_counts into code lengths, least frequent (longest) first
+	uint32* a = sorted_counts;
+	int32 n = (int32)used_count;
+	a[0] += a[1];
+	int32 root = 0;
+	int32 leaf = 2;
+	for (int32 next = 1; next < n - 1; ++next)
+	{
+		if (leaf >= n || a[root] < a[leaf])
+		{
+			a[next] = a[root];
+			a[root++] = (uint32)next;
+		}
+		else
+		{
+			a[next] = a[leaf++];
+		}
+
+		if (leaf >= n || (root < next && a[root] < a[leaf]))
+		{
+			a[next] += a[root];
+			a[root++] = (uint32)next;
+		}
+		else
+		{
+			a[next] += a[leaf++];
+		}
+	}
+
+	a[n - 2] = 0;
+	for (int32 next = n - 3; next >= 0; --next)
+	{
+		a[next] = a[a[next]] + 1;
+	}
+
+	int32 available = 1;
+	int32 used = 0;
+	uint32 depth = 0;
+	root = n - 2;
+	int32 next = n - 1;
+	while (available > 0)
+	{
+		while (root >= 0 && a[root] == depth)
+		{
+			++used;
+			--root;
+		}
+
+		while (available > used)
+		{
+			a[next--] = depth;
+			--available;
+		}
+
+		available = 2 * used;
+		++depth;
+		used = 0;
+	}
+
+	uint32 length_counts[33] = {};
+	for (uint32 i = 0; i < used_count; ++i)
+	{
+		++length_counts[a[i] < 32 ? a[i] : 32];
+	}
+
+	for (uint32 length = max_length + 1; length <= 32; ++length)
+	{
+		length_counts[max_length] += length_counts[length];
+		length_counts[length] = 0;
+	}
+
+	uint32 total = 0;
+	for (uint32 length = 1; length <= max_length; ++length)
+	{
+		total += length_counts[length] << (max_length - length);
+	}
+
+	while (total != (1u << max_length))
+	{
+		--length_counts[max_length];
+		for (uint32 length = max_length - 1; length > 0; --length)
+		{
+			if (length_counts[length])
+			{
+				--length_counts[length];
+				length_counts[length + 1] += 2;
+				break;
+			}
+		}
+		--total;
+	}
+
+	// most frequent symbols get the shortest codes
+	uint32 sorted_i = used_count;
+	for (uint32 length = 1; length <= max_length; ++length)
+	{
+		for (uint32 i = 0; i < length_counts[length]; ++i)
+		{
+			out_lengths[sorted_symbols[--sorted_i]] = (uint8)length;
+		}
+	}
+}
+
+// canonical codes from code lengths, bit reversed because deflate packs codes msb first
+static void deflate_build_codes(const uint8* lengths, uint32 symbol_count, uint16* out_codes)
+{
+	uint32 length_counts[c_max_code_length + 1] = {};
+	for (uint32 i = 0; i < symbol_count; ++i)
+	{
+		++length_counts[lengths[i]];
+	}
+	length_counts[0] = 0;
+
+	uint32 next_codes[c_max_code_length + 1];
+	uint32 code = 0;
+	for (uint32 length = 1; length <= c_max_code_length; ++length)
+	{
+		code = (code + length_counts[length - 1]) << 1;
+		next_codes[length] = code;
+	}
+
+	for (uint32 symbol = 0; symbol < symbol_count; ++symbol)
+	{
+		uint32 length = lengths[symbol];
+		if (!length)
+		{
+			out_codes[symbol] = 0;
+			continue;
+		}
+
+		uint32 symbol_code = next_codes[length]++;
+		uint32 reversed_code = 0;
+		for (uint32 bit_i = 0; bit_i < length; ++bit_i)
+		{
+			reversed_code |= ((symbol_code >> bit_i) & 1) << (length - 1 - bit_i);
+		}
+
+		out_codes[symbol] = (uint16)reversed_code;
+	}
+}
+
+static void deflate_build_fixed_code(Deflate_Code* out_litlen_code, Deflate_Code* out_dist_code)
+{
+	for (uint32 i = 0; i < c_litlen_symbol_count; ++i)
+	{
+		out_litlen_code->lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+	}
+	deflate_build_codes(out_litlen_code->lengths, c_litlen_symbol_count, out_litlen_code->codes);
+
+	for (uint32 i = 0; i < c_dist_symbol_count; ++i)
+	{
+		out_dist_code->lengths[i] = 5;
+	}
+	deflate_build_codes(out_dist_code->lengths, c_dist_symbol_count, out_dist_code->codes);
+}
+
+static Deflate_Code s_fixed_litlen_code;
+static Deflate_Code s_fixed_dist_code;
+
+static bool create_fixed_codes()
+{
+	deflate_build_fixed_code(&s_fixed_litlen_code, &s_fixed_dist_code);
+	return true;
+}
+
+static bool s_fixed_codes_created = create_fixed_codes();
+
+// bits needed for the block's symbols with the given codes, not including the block header
+static uint32 deflate_block_data_bit_count(Deflate_State* state, Deflate_Code* litlen_code, Deflate_Code* dist_code)
+{
+	uint32 bit_count = 0;
+
+	for (uint32 i = 0; i < c_litlen_symbol_count; ++i)
+	{
+		bit_count += state->litlen_counts[i] * litlen_code->lengths[i];
+	}
+
+	for (uint32 i = 0; i < 29; ++i)
+	{
+		bit_count += state->litlen_counts[257 + i] * c_length_extra_bits[i];
+	}
+
+	for (uint32 i = 0; i < c_dist_symbol_count; ++i)
+	{
+		bit_count += state->dist_counts[i] * (dist_code->lengths[i] + c_dist_extra_bits[i]);
+	}
+
+	return bit_count;
+}
+
+static void deflate_write_stored_blocks(Deflate_State* state, uint32 start, uint32 end, bool is_final)
+{
+	Deflate_Bits* bits = &state->bits;
+
+	// always at least one block, even if it's empty
+	do
+	{
+		uint32 size = end - start < c_deflate_max_stored_size ? end - start : c_deflate_max_stored_size;
+		bool is_last = start + size == end;
+
+		deflate_write_bits(bits, is_final && is_last ? 1 : 0, 1);
+		deflate_write_bits(bits, 0, 2);
+		deflate_flush_bits(bits);
+
+		if ((uint32)(bits->out_end - bits->out) < size + 4)
+		{
+			bits->is_out_of_space = true;
+			return;
+		}
+
+		bits->out[0] = (uint8)size;
+		bits->out[1] = (uint8)(size >> 8);
+		bits->out[2] = (uint8)~size;
+		bits->out[3] = (uint8)(~size >> 8);
+		bytes_copy(&bits->out[4], &state->bytes[start], size);
+		bits->out += size + 4;
+
+		start += size;
+	} while (start < end);
+}
+
+static void deflate_write_symbols(Deflate_State* state, Deflate_Code* litlen_code, Deflate_Code* dist_code)
+{
+	Deflate_Bits* bits = &state->bits;
+
+	for (uint32 i = 0; i < state->symbol_count; ++i)
+	{
+		Deflate_Symbol* symbol = &state->symbols[i];
+		if (!symbol->distance)
+		{
+			deflate_write_bits(bits, litlen_code->codes[symbol->literal_or_length], litlen_code->lengths[symbol->literal_or_length]);
+			continue;
+		}
+
+		uint32 length_code = s_length_to_code_table[symbol->literal_or_length];
+		deflate_write_bits(bits, litlen_code->codes[257 + length_code], litlen_code->lengths[257 + length_code]);
+		deflate_write_bits(bits, symbol->literal_or_length - c_length_base[length_code], c_length_extra_bits[length_code]);
+
+		uint32 dist_code_i = deflate_dist_code(symbol->distance);
+		deflate_write_bits(bits, dist_code->codes[dist_code_i], dist_code->lengths[dist_code_i]);
+		deflate_write_bits(bits, symbol->distance - c_dist_base[dist_code_i], c_dist_extra_bits[dist_code_i]);
+	}
+
+	deflate_write_bits(bits, litlen_code->codes[c_end_of_block], litlen_code->lengths[c_end_of_block]);
+}
+
+// writes the symbols collected since the last block, as whichever block type is smallest
+static void deflate_write_block(Deflate_State* state, bool is_final)
+{
+	Deflate_Bits* bits = &state->bits;
+
+	state->litlen_counts[c_end_of_block] = 1;
+
+	// dynamic code, every code gets at least 2 symbols so it's complete, a single 1 bit code is allowed but
+	// not every decoder likes it
+	uint32 litlen_counts[c_litlen_symbol_count];
+	uint32 dist_counts[c_dist_symbol_count];
+	uint32 litlen_used_count = 0;
+	uint32 dist_used_count = 0;
+	for (uint32 i = 0; i < c_litlen_symbol_count; ++i)
+	{
+		litlen_counts[i] = state->litlen_counts[i];
+		litlen_used_count += litlen_counts[i] ? 1 : 0;
+	}
+	for (uint32 i = 0; i < c_dist_symbol_count; ++i)
+	{
+		dist_counts[i] = state->dist_counts[i];
+		dist_used_count += dist_counts[i] ? 1 : 0;
+	}
+	for (uint32 i = 0; litlen_used_count < 2; ++i)
+	{
+		if (!litlen_counts[i])
+		{
+			litlen_counts[i] = 1;
+			++litlen_used_count;
+		}
+	}
+	for (uint32 i = 0; dist_used_count < 2; ++i)
+	{
+		if (!dist_counts[i])
+		{
+			dist_counts[i] = 1;
+			++dist_used_count;
+		}
+	}
+
+	Deflate_Code litlen_code;
+	Deflate_Code dist_code;
+	deflate_build_code_lengths(litlen_counts, c_litlen_symbol_count, c_max_code_length, litlen_code.lengths);
+	deflate_build_codes(litlen_code.lengths, c_litlen_symbol_count, litlen_code.codes);
+	deflate_build_code_lengths(dist_counts, c_dist_symbol_count, c_max_code_length, dist_code.lengths);
+	deflate_build_codes(dist_code.lengths, c_dist_symbol_count, dist_code.codes);
+
+	uint32 litlen_count = 286;
+	while (litlen_count > 257 && !litlen_code.lengths[litlen_count - 1])
+	{
+		--litlen_count;
+	}
+
+	uint32 dist_count = c_dist_symbol_count;
+	while (dist_count > 1 && !dist_code.lengths[dist_count - 1])
+	{
+		--dist_count;
+	}
+
+	// code lengths are sent as one run, with runs of repeats packed with symbols 16, 17 and 18
+	uint8 lengths[c_litlen_symbol_count + c_dist_symbol_count];
+	for (uint32 i = 0; i < litlen_count; ++i)
+	{
+		lengths[i] = litlen_code.lengths[i];
+	}
+	for (uint32 i = 0; i < dist_count; ++i)
+	{
+		lengths[litlen_count + i] = dist_code.lengths[i];
+	}
+	uint32 length_count = litlen_count + dist_count;
+
+	uint8 precode_symbols[c_litlen_symbol_count + c_dist_symbol_count];
+	uint8 precode_extra[c_litlen_symbol_count + c_dist_symbol_count];
+	uint32 precode_symbol_count = 0;
+	uint32 precode_counts[c_precode_symbol_count] = {};
+
+	for (uint32 i = 0; i < length_count;)
+	{
+		uint8 length = lengths[i];
+		uint32 run = 1;
+		while (i + run < length_count && lengths[i + run] == length)
+		{
+			++run;
+		}
+
+		uint32 run_end = i + run;
+		if (length == 0 && run >= 3)
+		{
+			while (run >= 3)
+			{
+				uint32 repeat = run < 138 ? run : 138;
+				uint8 symbol = repeat >= 11 ? 18 : 17;
+				precode_symbols[precode_symbol_count] = symbol;
+				precode_extra[precode_symbol_count++] = (uint8)(repeat - (symbol == 18 ? 11 : 3));
+				++precode_counts[symbol];
+				run -= repeat;
+			}
+		}
+		else if (length != 0 && run >= 4)
+		{
+			precode_symbols[precode_symbol_count] = length;
+			precode_extra[precode_symbol_count++] = 0;
+			++precode_counts[length];
+			--run;
+
+			while (run >= 3)
+			{
+				uint32 repeat = run < 6 ? run : 6;
+				precode_symbols[precode_symbol_count] = 16;
+				precode_extra[precode_symbol_count++] = (uint8)(repeat - 3);
+				++precode_counts[16];
+				run -= repeat;
+			}
+		}
+
+		// whatever's left of the run is too short to repeat
+		for (; run; --run)
+		{
+			precode_symbols[precode_symbol_count] = length;
+			precode_extra[precode_symbol_count++] = 0;
+			++precode_counts[length];
+		}
+
+		i = run_end;
+	}
+
+	Deflate_Code precode_code;
+	deflate_build_code_lengths(precode_counts, c_precode_symbol_count, c_max_precode_length, precode_code.lengths);
+	deflate_build_codes(precode_code.lengths, c_precode_symbol_count, precode_code.codes);
+
+	uint32 precode_count = c_precode_symbol_count;
+	while (precode_count > 4 && !precode_code.lengths[c_precode_order[precode_count - 1]])
+	{
+		--precode_count;
+	}
+
+	// work out the size of each block type
+	uint32 dynamic_bit_count = 3 + 5 + 5 + 4 + (precode_count * 3);
+	for (uint32 i = 0; i < c_precode_symbol_count; ++i)
+	{
+		dynamic_bit_count += precode_counts[i] * precode_code.lengths[i];
+	}
+	dynamic_bit_count += (precode_counts[16] * 2) + (precode_counts[17] * 3) + (precode_counts[18] * 7);
+	dynamic_bit_count += deflate_block_data_bit_count(state, &litlen_code, &dist_code);
+
+	uint32 fixed_bit_count = 3 + deflate_block_data_bit_count(state, &s_fixed_litlen_code, &s_fixed_dist_code);
+
+	uint32 stored_size = state->block_end - state->block_start;
+	uint32 stored_block_count = stored_size ? (stored_size + c_deflate_max_stored_size - 1) / c_deflate_max_stored_size : 1;
+	uint32 first_padding = (8 - ((bits->bit_count + 3) & 7)) & 7;
+	uint32 stored_bit_count = first_padding + (stored_block_count * (3 + 32)) + ((stored_block_count - 1) * 5) + (stored_size * 8);
+
+	if (stored_bit_count <= dynamic_bit_count && stored_bit_count <= fixed_bit_count)
+	{
+		deflate_write_stored_blocks(state, state->block_start, state->block_end, is_final);
+	}
+	else if (fixed_bit_count <= dynamic_bit_count)
+	{
+		deflate_write_bits(bits, is_final ? 1 : 0, 1);
+		deflate_write_bits(bits, 1, 2);
+		deflate_write_symbols(state, &s_fixed_litlen_code, &s_fixed_dist_code);
+	}
+	else
+	{
+		deflate_write_bits(bits, is_final ? 1 : 0, 1);
+		deflate_write_bits(bits, 2, 2);
+		deflate_write_bits(bits, litlen_count - 257, 5);
+		deflate_write_bits(bits, dist_count - 1, 5);
+		deflate_write_bits(bits, precode_count - 4, 4);
+
+		for (uint32 i = 0; i < precode_count; ++i)
+		{
+			deflate_write_bits(bits, precode_code.lengths[c_precode_order[i]], 3);
+		}
+
+		for (uint32 i = 0; i < precode_symbol_count; ++i)
+		{
+			uint32 symbol = precode_symbols[i];
+			deflate_write_bits(bits, precode_code.codes[symbol], precode_code.lengths[symbol]);
+
+			if (symbol >= 16)
+			{
+				deflate_write_bits(bits, precode_extra[i], symbol == 16 ? 2 : symbol == 17 ? 3 : 7);
+			}
+		}
+
+		deflate_write_symbols(state, &litlen_code, &dist_code);
+	}
+
+	state->symbol_count = 0;
+	for (uint32 i = 0; i < c_litlen_symbol_count; ++i)
+	{
+		state->litlen_counts[i] = 0;
+	}
+	for (uint32 i = 0; i < c_dist_symbol_count; ++i)
+	{
+		state->dist_counts[i] = 0;
+	}
+	state->block_start = state->block_end;
+}
+
+static __forceinline void deflate_add_literal(Deflate_State* state)
+{
+	uint8 literal = state->bytes[state->block_end];
+
+	Deflate_Symbol* symbol = &state->symbols[state->symbol_count++];
+	symbol->literal_or_length = literal;
+	symbol->distance = 0;
+	++state->litlen_counts[literal];
+	++state->block_end;
+
+	if (state->symbol_count == c_deflate_block_symbol_count)
+	{
+		deflate_write_block(state, /*is_final*/ false);
+	}
+}
+
+static __forceinline void deflate_add_match(Deflate_State* state, uint32 length, uint32 distance)
+{
+	Deflate_Symbol* symbol = &state->symbols[state->symbol_count++];
+	symbol->literal_or_length = (uint16)length;
+	symbol->distance = (uint16)distance;
+	++state->litlen_counts[257 + s_length_to_code_table[length]];
+	++state->dist_counts[deflate_dist_code(distance)];
+	state->block_end += length;
+
+	if (state->symbol_count == c_deflate_block_symbol_count)
+	{
+		deflate_write_block(state, /*is_final*/ false);
+	}
+}
+
+// adds position to the hash chains if it hasn't been already, returns the start of the chain before it was
+// added, the caller has to make sure there are at least 3 bytes from position
+static __forceinline uint32 deflate_insert(Deflate_State* state, uint32 position)
+{
+	const uint8* bytes = &state->bytes[position];
+	uint32 hash = (((uint32)bytes[0] | ((uint32)bytes[1] << 8) | ((uint32)bytes[2] << 16)) * 0x9e3779b1) >> (32 - state->hash_bits);
+
+	uint32 chain_start = state->head[hash];
+	if (position >= state->next_insert_position)
+	{
+		state->prev[position % c_deflate_prev_size] = chain_start;
+		state->head[hash] = position;
+		state->next_insert_position = position + 1;
+		return chain_start;
+	}
+
+	// already in, so it's at the head
+	return state->prev[position % c_deflate_prev_size];
+}
+
+static uint32 deflate_longest_match(Deflate_State* state, uint32 position, uint32 chain_start, uint32 max_length, uint32 previous_length, uint32* out_distance)
+{
+	const Deflate_Level_Config* config = state->config;
+	const uint8* current = &state->bytes[position];
+	uint32 window_start = position > c_deflate_window_size ? position - c_deflate_window_size : 0;
+	uint32 nice_length = config->nice_length < max_length ? config->nice_length : max_length;
+	uint32 chain_length = previous_length >= config->good_length ? config->max_chain >> 2 : config->max_chain;
+
+	uint32 best_length = c_deflate_min_match - 1;
+	uint32 best_distance = 0;
+
+	uint32 candidate = chain_start;
+	while (candidate != c_deflate_no_position && candidate >= window_start && chain_length--)
+	{
+		const uint8* match = &state->bytes[candidate];
+
+		// check the byte which would make this the best match first, most candidates fail there
+		if (match[best_length] == current[best_length] && match[0] == current[0] && match[1] == current[1])
+		{
+			uint32 length = 2;
+			while (length + 8 <= max_length && *(const uint64*)&match[length] == *(const uint64*)&current[length])
+			{
+				length += 8;
+			}
+			while (length < max_length && match[length] == current[length])
+			{
+				++length;
+			}
+
+			if (length > best_length)
+			{
+				best_length = length;
+				best_distance = position - candidate;
+				if (length >= nice_length)
+				{
+					break;
+				}
+			}
+		}
+
+		uint32 next = state->prev[candidate % c_deflate_prev_size];
+		if (next >= candidate)
+		{
+			break;
+		}
+		candidate = next;
+	}
+
+	if (best_length == c_deflate_min_match && best_distance > c_deflate_too_far)
+	{
+		best_length = 0;
+	}
+
+	*out_distance = best_distance;
+	return best_length >= c_deflate_min_match ? best_length : 0;
+}
+
+static void deflate_compress(Deflate_State* state)
+{
+	const Deflate_Level_Config* config = state->config;
+	uint32 bytes_size = state->bytes_size;
+
+	uint32 position = 0;
+	while (position < bytes_size)
+	{
+		uint32 max_length = bytes_size - position < c_deflate_max_match ? bytes_size - position : c_deflate_max_match;
+		if (max_length < c_deflate_min_match)
+		{
+			deflate_add_literal(state);
+			++position;
+			continue;
+		}
+
+		uint32 distance;
+		uint32 chain_start = deflate_insert(state, position);
+		uint32 length = deflate_longest_match(state, position, chain_start, max_length, /*previous_length*/ 0, &distance);
+
+		// lazy matching, if the match starting at the next byte is longer then this byte is better off as a literal
+		if (config->lazy_length)
+		{
+			while (length && length < config->lazy_length && bytes_size - (position + 1) >= c_deflate_min_match)
+			{
+				uint32 next_max_length = max_length < bytes_size - (position + 1) ? max_length : bytes_size - (position + 1);
+				uint32 next_distance;
+				uint32 next_chain_start = deflate_insert(state, position + 1);
+				uint32 next_length = deflate_longest_match(state, position + 1, next_chain_start, next_max_length, length, &next_distance);
+				if (next_length <= length)
+				{
+					break;
+				}
+
+				deflate_add_literal(state);
+				++position;
+				max_length = next_max_length;
+				length = next_length;
+				distance = next_distance;
+			}
+		}
+
+		if (!length)
+		{
+			deflate_add_literal(state);
+			++position;
+			continue;
+		}
+
+		deflate_add_match(state, length, distance);
+
+		if (config->lazy_length || length <= config->max_insert_length)
+		{
+			uint32 insert_end = position + length;
+			if (insert_end > bytes_size - (c_deflate_min_match - 1))
+			{
+				insert_end = bytes_size - (c_deflate_min_match - 1);
+			}
+
+			for (uint32 i = position + 1; i < insert_end; ++i)
+			{
+				deflate_insert(state, i);
+			}
+		}
+		else
+		{
+			state->next_insert_position = position + length;
+		}
+
+		position += length;
+	}
+
+	deflate_write_block(state, /*is_final*/ true);
+}
+
+// most bytes deflate_bytes can produce, worst case is every block being stored
+uint32 deflate_bound(uint32 bytes_size)
+{
+	return bytes_size + (bytes_size / 1024) + 64;
+}
+
+// level is 0-9 like zlib, 0 stores, 1 is fastest and 9 is smallest. Returns the size of the zlib stream
+// written to out_deflated_bytes, or 0 if it didn't fit. With capacity of at least deflate_bound it will always fit
+uint32 deflate_bytes(const uint8* bytes, uint32 bytes_size, int32 level, uint8* out_deflated_bytes, uint32 out_deflated_bytes_capacity, Linear_Allocator* temp_allocator)
+{
+	level = level < 0 ? 0 : level > 9 ? 9 : level;
+
+	if (out_deflated_bytes_capacity < 6)
+	{
+		return 0;
+	}
+
+	// zlib header, deflate with a 32k window, and the level in the check bits
+	uint32 cmf = 0x78;
+	uint32 flevel = level <= 1 ? 0 : level <= 5 ? 1 : level == 6 ? 2 : 3;
+	uint32 flg = flevel << 6;
+	flg += 31 - (((cmf << 8) | flg) % 31);
+	out_deflated_bytes[0] = (uint8)cmf;
+	out_deflated_bytes[1] = (uint8)flg;
+
+	Linear_Allocator state_allocator = *temp_allocator;
+
+	Deflate_State* state = (Deflate_State*)linear_allocator_alloc(&state_allocator, sizeof(Deflate_State));
+	*state = {};
+	state->bytes = bytes;
+	state->bytes_size = bytes_size;
+	state->config = &c_deflate_level_configs[level];
+	state->bits.out = out_deflated_bytes + 2;
+	state->bits.out_end = out_deflated_bytes + out_deflated_bytes_capacity - 4; // room for the adler32
+
+	if (level == 0)
+	{
+		deflate_write_stored_blocks(state, 0, bytes_size, /*is_final*/ true);
+	}
+	else
+	{
+		// smaller hash table for smaller inputs, it has to be cleared each time
+		state->hash_bits = 8;
+		while (state->hash_bits < c_deflate_max_hash_bits && (1u << state->hash_bits) < bytes_size)
+		{
+			++state->hash_bits;
+		}
+
+		state->head = (uint32*)linear_allocator_alloc(&state_allocator, sizeof(uint32) << state->hash_bits);
+		for (uint32 i = 0; i < (1u << state->hash_bits); ++i)
+		{
+			state->head[i] = c_deflate_no_position;
+		}
+
+		// prev doesn't need clearing, chains only lead to positions which have been inserted
+		state->prev = (uint32*)linear_allocator_alloc(&state_allocator, sizeof(uint32) * c_deflate_prev_size);
+		state->symbols = (Deflate_Symbol*)linear_allocator_alloc(&state_allocator, sizeof(Deflate_Symbol) * c_deflate_block_symbol_count);
+
+		deflate_compress(state);
+	}
+
+	deflate_flush_bits(&state->bits);
+
+	if (state->bits.is_out_of_space)
+	{
+		return 0;
+	}
+
+	uint32 adler = (uint32)adler32(1, bytes, bytes_size);
+	uint8* out = state->bits.out;
+	out[0] = (uint8)(adler >> 24);
+	out[1] = (uint8)(adler >> 16);
+	out[2] = (uint8)(adler >> 8);
+	out[3] = (uint8)adler;
+	out += 4;
+
+	return (uint32)(out - out_deflated_bytes);
+}
\ No newline at end of file
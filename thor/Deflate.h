@@ -0,0 +1,8 @@
+#pragma once
+
+#include "Core.h"
+
+
+
+uint32 deflate_bound(uint32 bytes_size);
+uint32 deflate_bytes(const uint8* bytes, uint32 bytes_size, int32 level, uint8* out_deflated_bytes, uint32 out_deflated_bytes_capacity, struct Linear_Allocator* temp_allocator);
\ No newline at end of file
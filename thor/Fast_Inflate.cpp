@@ -0,0 +1,684 @@
+#include "Fast_Inflate.h"
+
+#include "Memory.h"
+#include "zlib/zlib.h"
+
+
+
+// whole buffer inflate, when all of the input is in memory and the output size is known there's no need for any of
+// the state machine stuff zlib does to be able to stop and resume anywhere. Bits are refilled a word at a time, codes
+// are decoded with one lookup in a wide table (plus one more for long codes), and matches are copied a word at a time
+
+// decode table entries:
+// bits 0-7		number of bits to consume, the codeword length (or the primary table bits for a subtable pointer)
+// bits 8-12	number of extra bits for a length/distance (or the subtable bits for a subtable pointer)
+// bit 13		literal
+// bit 14		subtable pointer
+// bit 15		end of block
+// bits 16-31	literal byte, length/distance base, or index of the subtable
+// an entry of 0 is a code which isn't in use, which is an error if it turns up
+constexpr uint32 c_entry_literal = 1 << 13;
+constexpr uint32 c_entry_subtable = 1 << 14;
+constexpr uint32 c_entry_end_of_block = 1 << 15;
+
+constexpr uint32 c_litlen_table_bits = 11;
+constexpr uint32 c_dist_table_bits = 8;
+constexpr uint32 c_precode_table_bits = 7;
+
+// most entries each table can need with those primary bits, including subtables (see zlib's examples/enough.c)
+constexpr uint32 c_litlen_table_size = 2342;
+constexpr uint32 c_dist_table_size = 402;
+constexpr uint32 c_precode_table_size = 128;
+
+constexpr uint32 c_litlen_symbol_count = 288;
+constexpr uint32 c_dist_symbol_count = 32;
+constexpr uint32 c_precode_symbol_count = 19;
+constexpr uint32 c_max_code_length = 15;
+
+static const uint16 c_length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8 c_length_extra_bits[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16 c_dist_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8 c_dist_extra_bits[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+static const uint8 c_precode_order[c_precode_symbol_count] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+// what each symbol decodes to, i.e. a table entry without the length
+static uint32* create_litlen_symbol_results()
+{
+	static uint32 results[c_litlen_symbol_count];
+
+	for (uint32 i = 0; i < 256; ++i)
+	{
+		results[i] = c_entry_literal | (i << 16);
+	}
+
+	results[256] = c_entry_end_of_block;
+
+	for (uint32 i = 0; i < 29; ++i)
+	{
+		results[257 + i] = ((uint32)c_length_base[i] << 16) | ((uint32)c_length_extra_bits[i] << 8);
+	}
+
+	results[286] = 0; // 286 and 287 are never valid
+	results[287] = 0;
+
+	return results;
+}
+
+static uint32* create_dist_symbol_results()
+{
+	static uint32 results[c_dist_symbol_count];
+
+	for (uint32 i = 0; i < 30; ++i)
+	{
+		results[i] = ((uint32)c_dist_base[i] << 16) | ((uint32)c_dist_extra_bits[i] << 8);
+	}
+
+	results[30] = 0; // 30 and 31 are never valid
+	results[31] = 0;
+
+	return results;
+}
+
+static uint32* create_precode_symbol_results()
+{
+	static uint32 results[c_precode_symbol_count];
+
+	// literal flag is only there to make the entry for symbol 0 non zero
+	for (uint32 i = 0; i < c_precode_symbol_count; ++i)
+	{
+		results[i] = c_entry_literal | (i << 16);
+	}
+
+	return results;
+}
+
+static uint32* s_litlen_symbol_results = create_litlen_symbol_results();
+static uint32* s_dist_symbol_results = create_dist_symbol_results();
+static uint32* s_precode_symbol_results = create_precode_symbol_results();
+
+// fills in the decode table for a canonical huffman code given the code length of each symbol (0 for unused),
+// returns false if the lengths don't make a valid code
+static bool fast_inflate_build_table(
+	const uint8* lengths,
+	uint32 symbol_count,
+	const uint32* symbol_results,
+	uint32 table_bits,
+	uint32* table,
+	uint32 table_size,
+	bool is_precode)
+{
+	uint16 counts[c_max_code_length + 1] = {};
+	for (uint32 i = 0; i < symbol_count; ++i)
+	{
+		++counts[lengths[i]];
+	}
+	counts[0] = 0;
+
+	uint32 max_length = 0;
+	int32 codes_left = 1;
+	for (uint32 length = 1; length <= c_max_code_length; ++length)
+	{
+		codes_left = (codes_left << 1) - counts[length];
+		if (codes_left < 0)
+		{
+			return false; // over subscribed
+		}
+
+		if (counts[length])
+		{
+			max_length = length;
+		}
+	}
+
+	for (uint32 i = 0; i < table_size; ++i)
+	{
+		table[i] = 0;
+	}
+
+	// no codes at all is fine (e.g. distances in a block of only literals), any use of the table is an error
+	if (max_length == 0)
+	{
+		return true;
+	}
+
+	// same rule as zlib, an incomplete code is only allowed if it's a single 1 bit code
+	if (codes_left > 0 && (is_precode || max_length != 1))
+	{
+		return false;
+	}
+
+	// symbols sorted by code length, then by symbol, which is the order canonical codes are given out in
+	uint16 offsets[c_max_code_length + 2];
+	offsets[1] = 0;
+	for (uint32 length = 1; length <= c_max_code_length; ++length)
+	{
+		offsets[length + 1] = offsets[length] + counts[length];
+	}
+
+	uint16 sorted_symbols[c_litlen_symbol_count];
+	for (uint32 i = 0; i < symbol_count; ++i)
+	{
+		if (lengths[i])
+		{
+			sorted_symbols[offsets[lengths[i]]++] = (uint16)i;
+		}
+	}
+
+	uint16 remaining_counts[c_max_code_length + 1];
+	for (uint32 length = 0; length <= c_max_code_length; ++length)
+	{
+		remaining_counts[length] = counts[length];
+	}
+
+	uint32 primary_size = 1 << table_bits;
+	uint32 table_end = primary_size;
+	uint32 subtable_prefix = (uint32)-1;
+	uint32 subtable_start = 0;
+	uint32 subtable_bits = 0;
+
+	uint32 code = 0;
+	uint32 sorted_i = 0;
+	for (uint32 length = 1; length <= max_length; ++length)
+	{
+		for (uint32 i = 0; i < counts[length]; ++i)
+		{
+			uint32 symbol = sorted_symbols[sorted_i++];
+			uint32 result = symbol_results[symbol];
+
+			// codes are packed msb first, but the bit buffer is lsb first
+			uint32 reversed_code = 0;
+			for (uint32 bit_i = 0; bit_i < length; ++bit_i)
+			{
+				reversed_code |= ((code >> bit_i) & 1) << (length - 1 - bit_i);
+			}
+
+			if (length <= table_bits)
+			{
+				uint32 entry = result ? result | length : 0;
+				for (uint32 table_i = reversed_code; table_i < primary_size; table_i += 1 << length)
+				{
+					table[table_i] = entry;
+				}
+			}
+			else
+			{
+				uint32 prefix = reversed_code & (primary_size - 1);
+				if (prefix != subtable_prefix)
+				{
+					// the subtable needs enough bits for every remaining code with this prefix, same as zlib works it out
+					subtable_bits = length - table_bits;
+					int32 subtable_codes_left = 1 << subtable_bits;
+					while (subtable_bits + table_bits < max_length)
+					{
+						subtable_codes_left -= remaining_counts[subtable_bits + table_bits];
+						if (subtable_codes_left <= 0)
+						{
+							break;
+						}
+
+						++subtable_bits;
+						subtable_codes_left <<= 1;
+					}
+
+					subtable_start = table_end;
+					table_end += 1 << subtable_bits;
+					if (table_end > table_size)
+					{
+						return false;
+					}
+
+					subtable_prefix = prefix;
+					table[prefix] = c_entry_subtable | (subtable_start << 16) | (subtable_bits << 8) | table_bits;
+				}
+
+				uint32 subtable_length = length - table_bits;
+				uint32 entry = result ? result | subtable_length : 0;
+				for (uint32 table_i = reversed_code >> table_bits; table_i < (1u << subtable_bits); table_i += 1 << subtable_length)
+				{
+					table[subtable_start + table_i] = entry;
+				}
+			}
+
+			--remaining_counts[length];
+			++code;
+		}
+
+		code <<= 1;
+	}
+
+	return true;
+}
+
+static uint32 s_fixed_litlen_table[c_litlen_table_size];
+static uint32 s_fixed_dist_table[c_dist_table_size];
+
+static bool create_fixed_tables()
+{
+	uint8 lengths[c_litlen_symbol_count];
+	for (uint32 i = 0; i < c_litlen_symbol_count; ++i)
+	{
+		lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+	}
+
+	bool success = fast_inflate_build_table(lengths, c_litlen_symbol_count, s_litlen_symbol_results, c_litlen_table_bits, s_fixed_litlen_table, c_litlen_table_size, /*is_precode*/ false);
+
+	for (uint32 i = 0; i < c_dist_symbol_count; ++i)
+	{
+		lengths[i] = 5;
+	}
+
+	success = success && fast_inflate_build_table(lengths, c_dist_symbol_count, s_dist_symbol_results, c_dist_table_bits, s_fixed_dist_table, c_dist_table_size, /*is_precode*/ false);
+	assert(success);
+
+	return success;
+}
+
+static bool s_fixed_tables_created = create_fixed_tables();
+
+struct Inflate_Bits
+{
+	uint64 bit_buffer; // next bits of input, lsb first
+	uint32 bit_count;
+	const uint8* in;
+	const uint8* in_end;
+	uint32 overrun_count; // zero bytes added past the end of the input, too many of these means the input was cut short
+};
+
+// tops the bit buffer up to at least 56 bits
+static __forceinline void fast_inflate_refill(Inflate_Bits* bits)
+{
+	if (bits->in_end - bits->in >= 8)
+	{
+		// bits above bit_count might already be filled from the last refill, but they'll be the same bits again
+		bits->bit_buffer |= *(const uint64*)bits->in << bits->bit_count;
+		uint32 byte_count = (63 - bits->bit_count) >> 3;
+		bits->in += byte_count;
+		bits->bit_count += byte_count << 3;
+	}
+	else
+	{
+		while (bits->bit_count <= 56)
+		{
+			if (bits->in != bits->in_end)
+			{
+				bits->bit_buffer |= (uint64)*bits->in << bits->bit_count;
+				++bits->in;
+			}
+			else
+			{
+				++bits->overrun_count;
+			}
+
+			bits->bit_count += 8;
+		}
+	}
+}
+
+static __forceinline uint32 fast_inflate_peek(Inflate_Bits* bits, uint32 bit_count)
+{
+	return (uint32)(bits->bit_buffer & ((1ull << bit_count) - 1));
+}
+
+static __forceinline void fast_inflate_consume(Inflate_Bits* bits, uint32 bit_count)
+{
+	bits->bit_buffer >>= bit_count;
+	bits->bit_count -= bit_count;
+}
+
+// drops bits to get to a byte boundary, then gives back any whole bytes in the bit buffer so bits->in is the next byte
+static bool fast_inflate_align_to_byte(Inflate_Bits* bits)
+{
+	fast_inflate_consume(bits, bits->bit_count & 7);
+
+	uint32 buffered_byte_count = bits->bit_count >> 3;
+	if (bits->overrun_count > buffered_byte_count)
+	{
+		return false;
+	}
+
+	bits->in -= buffered_byte_count - bits->overrun_count;
+	bits->bit_buffer = 0;
+	bits->bit_count = 0;
+	bits->overrun_count = 0;
+
+	return true;
+}
+
+static __forceinline uint32 fast_inflate_decode(Inflate_Bits* bits, const uint32* table, uint32 table_bits)
+{
+	uint32 entry = table[fast_inflate_peek(bits, table_bits)];
+	if (entry & c_entry_subtable)
+	{
+		fast_inflate_consume(bits, table_bits);
+		entry = table[(entry >> 16) + fast_inflate_peek(bits, (entry >> 8) & 31)];
+	}
+
+	fast_inflate_consume(bits, entry & 0xff);
+
+	return entry;
+}
+
+static bool fast_inflate_read_dynamic_tables(Inflate_Bits* bits, uint32* litlen_table, uint32* dist_table)
+{
+	fast_inflate_refill(bits);
+
+	uint32 litlen_count = fast_inflate_peek(bits, 5) + 257;
+	fast_inflate_consume(bits, 5);
+	uint32 dist_count = fast_inflate_peek(bits, 5) + 1;
+	fast_inflate_consume(bits, 5);
+	uint32 precode_count = fast_inflate_peek(bits, 4) + 4;
+	fast_inflate_consume(bits, 4);
+
+	if (litlen_count > 286 || dist_count > 30)
+	{
+		return false;
+	}
+
+	uint8 precode_lengths[c_precode_symbol_count] = {};
+	for (uint32 i = 0; i < precode_count; ++i)
+	{
+		fast_inflate_refill(bits);
+		precode_lengths[c_precode_order[i]] = (uint8)fast_inflate_peek(bits, 3);
+		fast_inflate_consume(bits, 3);
+	}
+
+	uint32 precode_table[c_precode_table_size];
+	if (!fast_inflate_build_table(precode_lengths, c_precode_symbol_count, s_precode_symbol_results, c_precode_table_bits, precode_table, c_precode_table_size, /*is_precode*/ true))
+	{
+		return false;
+	}
+
+	// litlen and dist code lengths are one run, repeats can cross from one to the other
+	uint8 lengths[c_litlen_symbol_count + c_dist_symbol_count] = {};
+	uint32 length_count = litlen_count + dist_count;
+	uint32 length_i = 0;
+	while (length_i < length_count)
+	{
+		fast_inflate_refill(bits);
+
+		uint32 entry = fast_inflate_decode(bits, precode_table, c_precode_table_bits);
+		if (!entry)
+		{
+			return false;
+		}
+
+		uint32 symbol = entry >> 16;
+		if (symbol < 16)
+		{
+			lengths[length_i++] = (uint8)symbol;
+			continue;
+		}
+
+		uint8 repeat_length;
+		uint32 repeat_count;
+		if (symbol == 16)
+		{
+			if (length_i == 0)
+			{
+				return false;
+			}
+
+			repeat_length = lengths[length_i - 1];
+			repeat_count = 3 + fast_inflate_peek(bits, 2);
+			fast_inflate_consume(bits, 2);
+		}
+		else if (symbol == 17)
+		{
+			repeat_length = 0;
+			repeat_count = 3 + fast_inflate_peek(bits, 3);
+			fast_inflate_consume(bits, 3);
+		}
+		else
+		{
+			repeat_length = 0;
+			repeat_count = 11 + fast_inflate_peek(bits, 7);
+			fast_inflate_consume(bits, 7);
+		}
+
+		if (repeat_count > length_count - length_i)
+		{
+			return false;
+		}
+
+		for (uint32 i = 0; i < repeat_count; ++i)
+		{
+			lengths[length_i++] = repeat_length;
+		}
+	}
+
+	// there has to be an end of block code
+	if (!lengths[256])
+	{
+		return false;
+	}
+
+	uint8 dist_lengths[c_dist_symbol_count] = {};
+	for (uint32 i = 0; i < dist_count; ++i)
+	{
+		dist_lengths[i] = lengths[litlen_count + i];
+	}
+
+	for (uint32 i = litlen_count; i < c_litlen_symbol_count; ++i)
+	{
+		lengths[i] = 0;
+	}
+
+	return fast_inflate_build_table(lengths, c_litlen_symbol_count, s_litlen_symbol_results, c_litlen_table_bits, litlen_table, c_litlen_table_size, /*is_precode*/ false) &&
+		fast_inflate_build_table(dist_lengths, c_dist_symbol_count, s_dist_symbol_results, c_dist_table_bits, dist_table, c_dist_table_size, /*is_precode*/ false);
+}
+
+// copies a match, when there's room to spare at the end of the output this is done 8 bytes at a time and may write
+// up to 7 bytes past the end of the match, which later output overwrites
+static __forceinline void fast_inflate_copy_match(uint8* out, uint8* out_end, uint32 distance, uint32 length)
+{
+	const uint8* src = out - distance;
+	uint8* dst_end = out + length;
+
+	if ((uint32)(out_end - dst_end) >= 8)
+	{
+		if (distance >= 8)
+		{
+			do
+			{
+				*(uint64*)out = *(const uint64*)src;
+				out += 8;
+				src += 8;
+			} while (out < dst_end);
+			return;
+		}
+
+		if (distance == 1)
+		{
+			// run of the same byte
+			uint64 word = *src * 0x0101010101010101ull;
+			do
+			{
+				*(uint64*)out = word;
+				out += 8;
+			} while (out < dst_end);
+			return;
+		}
+
+		// repeating pattern shorter than a word, only the first distance bytes of each word are right, but the
+		// next store starts from there
+		do
+		{
+			*(uint64*)out = *(const uint64*)src;
+			out += distance;
+		} while (out < dst_end);
+		return;
+	}
+
+	while (out < dst_end)
+	{
+		*out++ = *src++;
+	}
+}
+
+// expects a zlib stream (header, deflate blocks, adler32), returns false if the data is invalid, or it doesn't fit
+// in out_inflated_bytes, or the checksum doesn't match
+bool fast_inflate_bytes(const uint8* deflated_bytes, uint32 deflated_bytes_size, uint8* out_inflated_bytes, uint32 inflated_bytes_size, uint32* out_bytes_inflated)
+{
+	*out_bytes_inflated = 0;
+
+	if (deflated_bytes_size < 6)
+	{
+		return false;
+	}
+
+	// zlib header, deflate compression, window no bigger than 32k, check bits and no preset dictionary
+	uint32 cmf = deflated_bytes[0];
+	uint32 flg = deflated_bytes[1];
+	if ((cmf & 0x0f) != 8 || (cmf >> 4) > 7 || ((cmf << 8) | flg) % 31 != 0 || (flg & 0x20))
+	{
+		return false;
+	}
+
+	Inflate_Bits bits = {};
+	bits.in = deflated_bytes + 2;
+	bits.in_end = deflated_bytes + deflated_bytes_size;
+
+	uint8* out = out_inflated_bytes;
+	uint8* out_end = out_inflated_bytes + inflated_bytes_size;
+
+	uint32 litlen_table[c_litlen_table_size];
+	uint32 dist_table[c_dist_table_size];
+
+	bool is_final_block;
+	do
+	{
+		fast_inflate_refill(&bits);
+
+		is_final_block = fast_inflate_peek(&bits, 1);
+		uint32 block_type = fast_inflate_peek(&bits, 3) >> 1;
+		fast_inflate_consume(&bits, 3);
+
+		const uint32* block_litlen_table;
+		const uint32* block_dist_table;
+
+		if (block_type == 0)
+		{
+			// stored
+			if (!fast_inflate_align_to_byte(&bits) || bits.in_end - bits.in < 4)
+			{
+				return false;
+			}
+
+			uint32 length = bits.in[0] | (bits.in[1] << 8);
+			uint32 inverse_length = bits.in[2] | (bits.in[3] << 8);
+			bits.in += 4;
+
+			if (length != (~inverse_length & 0xffff) ||
+				(uint32)(bits.in_end - bits.in) < length ||
+				(uint32)(out_end - out) < length)
+			{
+				return false;
+			}
+
+			bytes_copy(out, bits.in, length);
+			out += length;
+			bits.in += length;
+			continue;
+		}
+		else if (block_type == 1)
+		{
+			block_litlen_table = s_fixed_litlen_table;
+			block_dist_table = s_fixed_dist_table;
+		}
+		else if (block_type == 2)
+		{
+			if (!fast_inflate_read_dynamic_tables(&bits, litlen_table, dist_table))
+			{
+				return false;
+			}
+
+			block_litlen_table = litlen_table;
+			block_dist_table = dist_table;
+		}
+		else
+		{
+			return false;
+		}
+
+		while (true)
+		{
+			// longest length + distance is 15 + 5 + 15 + 13 = 48 bits, so one refill is always enough
+			fast_inflate_refill(&bits);
+
+			uint32 entry = fast_inflate_decode(&bits, block_litlen_table, c_litlen_table_bits);
+			if (entry & c_entry_literal)
+			{
+				if (out == out_end)
+				{
+					return false;
+				}
+
+				*out++ = (uint8)(entry >> 16);
+
+				// enough bits left for another code without refilling, literals often come in runs
+				entry = fast_inflate_decode(&bits, block_litlen_table, c_litlen_table_bits);
+				if (entry & c_entry_literal)
+				{
+					if (out == out_end)
+					{
+						return false;
+					}
+
+					*out++ = (uint8)(entry >> 16);
+					continue;
+				}
+
+				fast_inflate_refill(&bits);
+			}
+
+			if (entry & c_entry_end_of_block)
+			{
+				break;
+			}
+
+			if (!entry)
+			{
+				return false;
+			}
+
+			uint32 length_extra_bits = (entry >> 8) & 31;
+			uint32 length = (entry >> 16) + fast_inflate_peek(&bits, length_extra_bits);
+			fast_inflate_consume(&bits, length_extra_bits);
+
+			entry = fast_inflate_decode(&bits, block_dist_table, c_dist_table_bits);
+			if (!entry)
+			{
+				return false;
+			}
+
+			uint32 dist_extra_bits = (entry >> 8) & 31;
+			uint32 distance = (entry >> 16) + fast_inflate_peek(&bits, dist_extra_bits);
+			fast_inflate_consume(&bits, dist_extra_bits);
+
+			if (distance > (uint32)(out - out_inflated_bytes) || length > (uint32)(out_end - out))
+			{
+				return false;
+			}
+
+			fast_inflate_copy_match(out, out_end, distance, length);
+			out += length;
+		}
+	} while (!is_final_block);
+
+	// adler32 of the inflated data follows the last block, big endian
+	if (!fast_inflate_align_to_byte(&bits) || bits.in_end - bits.in < 4)
+	{
+		return false;
+	}
+
+	uint32 expected_adler = ((uint32)bits.in[0] << 24) | ((uint32)bits.in[1] << 16) | ((uint32)bits.in[2] << 8) | bits.in[3];
+	uint32 bytes_inflated = (uint32)(out - out_inflated_bytes);
+	if (adler32(1, out_inflated_bytes, bytes_inflated) != expected_adler)
+	{
+		return false;
+	}
+
+	*out_bytes_inflated = bytes_inflated;
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "Core.h"
+
+
+
+bool fast_inflate_bytes(const uint8* deflated_bytes, uint32 deflated_bytes_size, uint8* out_inflated_bytes, uint32 inflated_bytes_size, uint32* out_bytes_inflated);
\ No newline at end of file
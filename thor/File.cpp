@@ -1,10 +1,26 @@
 #include "File.h"
 
+#if _WIN32
 #include <Windows.h>
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "Memory.h"
 #include "String.h"
 
 
 
+typedef void (*On_Dir_Entry_Function)(const char* name, bool32 is_directory, void* state);
+
+#if _WIN32
+
 File_Handle file_open_read(const char* path)
 {
 	return CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, /*lpSecurityAttributes*/ nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, /*hTemplateFile*/ nullptr);
@@ -32,70 +48,134 @@ void file_read(File_Handle file, uint32 byte_count, void* bytes)
 	assert(success);
 }
 
-int32 file_read_i32(File_Handle file)
+// reads from position without needing a separate file_set_position, so is safe to use from several threads on the same handle
+void file_read_at(File_Handle file, uint64 position, uint32 byte_count, void* bytes)
 {
-	int32 i32;
-	file_read(file, sizeof(i32), &i32);
-	return i32;
+	OVERLAPPED overlapped = {};
+	overlapped.Offset = (DWORD)position;
+	overlapped.OffsetHigh = (DWORD)(position >> 32);
+
+	DWORD num_bytes_read;
+	bool success = ReadFile(file, bytes, byte_count, &num_bytes_read, &overlapped);
+	assert(success && num_bytes_read == byte_count);
 }
 
-uint32 file_read_u32(File_Handle file)
+void file_skip(File_Handle file, uint32 byte_count)
 {
-	uint32 u32;
-	file_read(file, sizeof(u32), &u32);
-	return u32;
+	LARGE_INTEGER distance;
+	distance.QuadPart = byte_count;
+	bool success = SetFilePointerEx(file, distance, /*lpNewFilePointer*/ nullptr, FILE_CURRENT);
+	assert(success);
 }
 
-uint16 file_read_u16(File_Handle file)
+uint64 file_size(File_Handle file)
 {
-	uint16 u16;
-	file_read(file, sizeof(u16), &u16);
-	return u16;
+	LARGE_INTEGER size;
+	bool success = GetFileSizeEx(file, &size);
+	assert(success);
+	return (uint64)size.QuadPart;
 }
 
-float32 file_read_f32(File_Handle file)
+// last write time, as seconds since 1970 (which is what pigg timestamps use)
+uint32 file_get_timestamp(File_Handle file)
 {
-	float32 f32;
-	file_read(file, sizeof(f32), &f32);
-	return f32;
+	FILETIME last_write_time;
+	bool success = GetFileTime(file, /*lpCreationTime*/ nullptr, /*lpLastAccessTime*/ nullptr, &last_write_time);
+	assert(success);
+
+	// FILETIME is 100ns intervals since 1601
+	constexpr uint64 c_filetime_1970 = 116444736000000000;
+	uint64 filetime = ((uint64)last_write_time.dwHighDateTime << 32) | last_write_time.dwLowDateTime;
+
+	return (uint32)((filetime - c_filetime_1970) / 10000000);
 }
 
-Vec_3f file_read_vec_3f(File_Handle file)
+uint64 file_get_position(File_Handle file)
 {
-	Vec_3f v;
-	file_read(file, sizeof(float32) * 3, &v);
-	return v;
+	LARGE_INTEGER distance = {};
+	LARGE_INTEGER position;
+	bool success = SetFilePointerEx(file, distance, &position, FILE_CURRENT);
+	assert(success);
+	return (uint64)position.QuadPart;
 }
 
-void file_skip(File_Handle file, uint32 byte_count)
+void file_set_position(File_Handle file, uint64 position)
 {
-	DWORD result = SetFilePointer(file, byte_count, /*PLONG lpDistanceToMoveHigh*/ nullptr, FILE_CURRENT);
-	assert(result != INVALID_SET_FILE_POINTER);
+	LARGE_INTEGER distance;
+	distance.QuadPart = (LONGLONG)position;
+	bool success = SetFilePointerEx(file, distance, /*lpNewFilePointer*/ nullptr, FILE_BEGIN);
+	assert(success);
+}
+
+void file_write_bytes(File_Handle file, uint32 byte_count, const void* bytes)
+{
+	DWORD num_bytes_written;
+	bool success = WriteFile(file, bytes, byte_count, &num_bytes_written, /*lpOverlapped*/ nullptr);
+	assert(success);
 }
 
-uint32 file_size(File_Handle file)
+// maps the whole file read only, can fail (e.g. not enough address space in 32 bit builds) in which case callers should fall back to file_read
+bool file_mapping_open(File_Mapping* out_mapping, File_Handle file)
 {
-	return GetFileSize(file, /*lpFileSizeHigh*/ nullptr);
+	*out_mapping = {};
+
+	uint64 size = file_size(file);
+	if (!size || size > (size_t)-1)
+	{
+		return false;
+	}
+
+	HANDLE mapping_handle = CreateFileMappingA(file, /*lpFileMappingAttributes*/ nullptr, PAGE_READONLY, /*dwMaximumSizeHigh*/ 0, /*dwMaximumSizeLow*/ 0, /*lpName*/ nullptr);
+	if (!mapping_handle)
+	{
+		return false;
+	}
+
+	void* bytes = MapViewOfFile(mapping_handle, FILE_MAP_READ, /*dwFileOffsetHigh*/ 0, /*dwFileOffsetLow*/ 0, /*dwNumberOfBytesToMap*/ 0);
+	if (!bytes)
+	{
+		CloseHandle(mapping_handle);
+		return false;
+	}
+
+	out_mapping->handle = mapping_handle;
+	out_mapping->bytes = (const uint8*)bytes;
+	out_mapping->size = size;
+
+	return true;
 }
 
-uint32 file_get_position(File_Handle file)
+void file_mapping_close(File_Mapping* mapping)
 {
-	DWORD result = SetFilePointer(file, 0, /*PLONG lpDistanceToMoveHigh*/ nullptr, FILE_CURRENT);
-	assert(result != INVALID_SET_FILE_POINTER);
-	return result;
+	if (mapping->bytes)
+	{
+		UnmapViewOfFile(mapping->bytes);
+		CloseHandle(mapping->handle);
+	}
+
+	*mapping = {};
 }
 
-void file_set_position(File_Handle file, uint32 position)
+// there's no readahead hint for a plain file handle on Win32, file_read_at through a File_Read_Queue is the way to 
+// get reads going early there
+void file_prefetch(File_Handle file, uint64 position, uint64 byte_count)
 {
-	DWORD result = SetFilePointer(file, position, /*PLONG lpDistanceToMoveHigh*/ nullptr, FILE_BEGIN);
-	assert(result != INVALID_SET_FILE_POINTER);
+	file; position; byte_count;
 }
 
-void file_write_bytes(File_Handle file, uint32 byte_count, void* bytes)
+void file_mapping_prefetch(File_Mapping* mapping, uint64 offset, uint64 byte_count)
 {
-	DWORD num_bytes_written;
-	bool success = WriteFile(file, bytes, byte_count, &num_bytes_written, /*lpOverlapped*/ nullptr);
-	assert(success);
+	assert(offset + byte_count <= mapping->size);
+
+	if (!byte_count)
+	{
+		return;
+	}
+
+	WIN32_MEMORY_RANGE_ENTRY range;
+	range.VirtualAddress = (void*)&mapping->bytes[offset];
+	range.NumberOfBytes = (SIZE_T)byte_count;
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, /*Flags*/ 0);
 }
 
 void dir_create(const char* path)
@@ -104,6 +184,11 @@ void dir_create(const char* path)
 	assert(success || GetLastError() == ERROR_ALREADY_EXISTS);
 }
 
+void file_delete(const char* path)
+{
+	DeleteFileA(path);
+}
+
 void file_search(const char* dir_path, const char* search_term, bool32 include_subdirs, On_File_Found_Function on_file_found, void* state)
 {
 	char search_path[MAX_PATH + 1];
@@ -152,4 +237,953 @@ void file_search(const char* dir_path, const char* search_term, bool32 include_s
 			FindClose(find_handle);
 		}
 	}
+}
+
+// calls on_dir_entry for everything directly inside dir_path except . and ..
+static void dir_iterate(const char* dir_path, On_Dir_Entry_Function on_dir_entry, void* state)
+{
+	char search_path[MAX_PATH + 1];
+	string_concat(search_path, sizeof(search_path), dir_path, "/*");
+
+	// basic info skips looking up the 8.3 name, and large fetch gets more entries per call
+	WIN32_FIND_DATAA find_data;
+	HANDLE find_handle = FindFirstFileExA(search_path, FindExInfoBasic, &find_data, FindExSearchNameMatch, /*lpSearchFilter*/ nullptr, FIND_FIRST_EX_LARGE_FETCH);
+	if (find_handle == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+
+	do
+	{
+		if (!string_equals(find_data.cFileName, ".") && !string_equals(find_data.cFileName, ".."))
+		{
+			on_dir_entry(find_data.cFileName, (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0, state);
+		}
+	} while (FindNextFileA(find_handle, &find_data));
+
+	FindClose(find_handle);
+}
+
+#else
+
+// file descriptors are stored straight in the handle, -1 is the same as INVALID_HANDLE_VALUE
+static File_Handle file_from_fd(int fd)
+{
+	return (File_Handle)(intptr_t)fd;
+}
+
+static int file_to_fd(File_Handle file)
+{
+	return (int)(intptr_t)file;
+}
+
+File_Handle file_open_read(const char* path)
+{
+	int fd = open(path, O_RDONLY);
+
+	// directories can be opened here but not with CreateFileA, keep the same behaviour as Win32
+	struct stat file_stat;
+	if (fd != -1 && fstat(fd, &file_stat) == 0 && S_ISDIR(file_stat.st_mode))
+	{
+		close(fd);
+		fd = -1;
+	}
+
+	return file_from_fd(fd);
+}
+
+File_Handle file_open_write(const char* path)
+{
+	return file_from_fd(open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644));
+}
+
+void file_close(File_Handle file)
+{
+	close(file_to_fd(file));
+}
+
+bool file_is_valid(File_Handle file)
+{
+	return file_to_fd(file) != -1;
+}
+
+void file_read(File_Handle file, uint32 byte_count, void* bytes)
+{
+	// read can return less than asked for, so keep going until it's all in
+	uint8* bytes_iter = (uint8*)bytes;
+	while (byte_count)
+	{
+		ssize_t result = read(file_to_fd(file), bytes_iter, byte_count);
+		if (result < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		assert(result > 0);
+		if (result <= 0)
+		{
+			return;
+		}
+
+		bytes_iter += result;
+		byte_count -= (uint32)result;
+	}
+}
+
+// reads from position without needing a separate file_set_position, so is safe to use from several threads on the same handle
+//
+// todo(jbr) File_Read_Queue just runs this blocking pread on its threads, io_uring isn't used. On Linux it could go
+// behind the same file_read_submit/file_read_wait calls (submit pushes an sqe per request, wait reaps cqes and sets
+// is_complete), without changing any callers
+void file_read_at(File_Handle file, uint64 position, uint32 byte_count, void* bytes)
+{
+	uint8* bytes_iter = (uint8*)bytes;
+	while (byte_count)
+	{
+		ssize_t result = pread(file_to_fd(file), bytes_iter, byte_count, (off_t)position);
+		if (result < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		assert(result > 0);
+		if (result <= 0)
+		{
+			return;
+		}
+
+		bytes_iter += result;
+		position += (uint64)result;
+		byte_count -= (uint32)result;
+	}
+}
+
+void file_skip(File_Handle file, uint32 byte_count)
+{
+	off_t result = lseek(file_to_fd(file), byte_count, SEEK_CUR);
+	assert(result != -1); result;
+}
+
+uint64 file_size(File_Handle file)
+{
+	struct stat file_stat;
+	int result = fstat(file_to_fd(file), &file_stat);
+	assert(result == 0); result;
+	return (uint64)file_stat.st_size;
+}
+
+// last write time, as seconds since 1970 (which is what pigg timestamps use)
+uint32 file_get_timestamp(File_Handle file)
+{
+	struct stat file_stat;
+	int result = fstat(file_to_fd(file), &file_stat);
+	assert(result == 0); result;
+	return (uint32)file_stat.st_mtime;
+}
+
+uint64 file_get_position(File_Handle file)
+{
+	off_t result = lseek(file_to_fd(file), 0, SEEK_CUR);
+	assert(result != -1);
+	return (uint64)result;
+}
+
+void file_set_position(File_Handle file, uint64 position)
+{
+	off_t result = lseek(file_to_fd(file), (off_t)position, SEEK_SET);
+	assert(result != -1); result;
+}
+
+void file_write_bytes(File_Handle file, uint32 byte_count, const void* bytes)
+{
+	const uint8* bytes_iter = (const uint8*)bytes;
+	while (byte_count)
+	{
+		ssize_t result = write(file_to_fd(file), bytes_iter, byte_count);
+		if (result < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		assert(result > 0);
+		if (result <= 0)
+		{
+			return;
+		}
+
+		bytes_iter += result;
+		byte_count -= (uint32)result;
+	}
+}
+
+// maps the whole file read only, can fail (e.g. not enough address space in 32 bit builds) in which case callers should fall back to file_read
+bool file_mapping_open(File_Mapping* out_mapping, File_Handle file)
+{
+	*out_mapping = {};
+
+	uint64 size = file_size(file);
+	if (!size || size > (size_t)-1)
+	{
+		return false;
+	}
+
+	void* bytes = mmap(/*addr*/ nullptr, (size_t)size, PROT_READ, MAP_PRIVATE, file_to_fd(file), /*offset*/ 0);
+	if (bytes == MAP_FAILED)
+	{
+		return false;
+	}
+
+	out_mapping->bytes = (const uint8*)bytes;
+	out_mapping->size = size;
+
+	return true;
+}
+
+void file_mapping_close(File_Mapping* mapping)
+{
+	if (mapping->bytes)
+	{
+		munmap((void*)mapping->bytes, (size_t)mapping->size);
+	}
+
+	*mapping = {};
+}
+
+// tells the OS we'll be reading this range soon so it can start reading it in, doesn't block
+void file_prefetch(File_Handle file, uint64 position, uint64 byte_count)
+{
+	// a length of 0 means to the end of the file to posix_fadvise
+	if (!byte_count)
+	{
+		return;
+	}
+
+	posix_fadvise(file_to_fd(file), (off_t)position, (off_t)byte_count, POSIX_FADV_WILLNEED);
+}
+
+void file_mapping_prefetch(File_Mapping* mapping, uint64 offset, uint64 byte_count)
+{
+	assert(offset + byte_count <= mapping->size);
+
+	if (!byte_count)
+	{
+		return;
+	}
+
+	// madvise needs a page aligned address
+	uint64 page_size = (uint64)sysconf(_SC_PAGESIZE);
+	uint64 page_offset = offset & ~(page_size - 1);
+	madvise((void*)&mapping->bytes[page_offset], (size_t)(byte_count + (offset - page_offset)), MADV_WILLNEED);
+}
+
+void dir_create(const char* path)
+{
+	int result = mkdir(path, 0755);
+	assert(result == 0 || errno == EEXIST); result;
+}
+
+void file_delete(const char* path)
+{
+	unlink(path);
+}
+
+static bool file_search_is_directory(const char* path, struct dirent* dir_entry)
+{
+	if (dir_entry->d_type != DT_UNKNOWN)
+	{
+		return dir_entry->d_type == DT_DIR;
+	}
+
+	// not all file systems fill in d_type
+	struct stat file_stat;
+	return stat(path, &file_stat) == 0 && S_ISDIR(file_stat.st_mode);
+}
+
+// search_term is a glob e.g. "*.pigg", matched without case like FindFirstFile does
+void file_search(const char* dir_path, const char* search_term, bool32 include_subdirs, On_File_Found_Function on_file_found, void* state)
+{
+	DIR* dir = opendir(dir_path);
+	if (!dir)
+	{
+		return;
+	}
+
+	// same order as the Win32 version, matches in this directory first and then sub directories
+	for (int32 pass = 0; pass < (include_subdirs ? 2 : 1); ++pass)
+	{
+		rewinddir(dir);
+
+		while (struct dirent* dir_entry = readdir(dir))
+		{
+			if (string_equals(dir_entry->d_name, ".") || string_equals(dir_entry->d_name, ".."))
+			{
+				continue;
+			}
+
+			char found_file_path[PATH_MAX + 1];
+			uint32 found_file_path_length = string_concat(found_file_path, sizeof(found_file_path), dir_path, "/");
+			string_copy(&found_file_path[found_file_path_length], sizeof(found_file_path) - found_file_path_length, dir_entry->d_name);
+
+			if (pass == 0)
+			{
+				if (fnmatch(search_term, dir_entry->d_name, FNM_CASEFOLD) == 0)
+				{
+					on_file_found(found_file_path, state);
+				}
+			}
+			else if (file_search_is_directory(found_file_path, dir_entry))
+			{
+				file_search(found_file_path, search_term, include_subdirs, on_file_found, state);
+			}
+		}
+	}
+
+	closedir(dir);
+}
+
+// calls on_dir_entry for everything directly inside dir_path except . and ..
+static void dir_iterate(const char* dir_path, On_Dir_Entry_Function on_dir_entry, void* state)
+{
+	DIR* dir = opendir(dir_path);
+	if (!dir)
+	{
+		return;
+	}
+
+	while (struct dirent* dir_entry = readdir(dir))
+	{
+		if (string_equals(dir_entry->d_name, ".") || string_equals(dir_entry->d_name, ".."))
+		{
+			continue;
+		}
+
+		bool32 is_directory;
+		if (dir_entry->d_type != DT_UNKNOWN)
+		{
+			is_directory = dir_entry->d_type == DT_DIR;
+		}
+		else
+		{
+			// not all file systems fill in d_type
+			char path[PATH_MAX + 1];
+			uint32 path_length = string_concat(path, sizeof(path), dir_path, "/");
+			string_copy(&path[path_length], sizeof(path) - path_length, dir_entry->d_name);
+
+			struct stat file_stat;
+			is_directory = stat(path, &file_stat) == 0 && S_ISDIR(file_stat.st_mode);
+		}
+
+		on_dir_entry(dir_entry->d_name, is_directory, state);
+	}
+
+	closedir(dir);
+}
+
+#endif // _WIN32
+
+void file_reader_create(File_Reader* out_reader, File_Handle file, uint8* buffer, uint32 buffer_capacity)
+{
+	assert(buffer_capacity > 0);
+
+	*out_reader = {};
+	out_reader->file = file;
+	out_reader->file_size = file_size(file);
+	out_reader->buffer = buffer;
+	out_reader->buffer_capacity = buffer_capacity;
+	out_reader->buffer_position = file_get_position(file);
+}
+
+void file_reader_create_from_memory(File_Reader* out_reader, const uint8* bytes, uint32 byte_count)
+{
+	*out_reader = {};
+	out_reader->file = nullptr;
+	out_reader->file_size = byte_count;
+	out_reader->buffer = (uint8*)bytes; // never written to, there's nothing to fill it from
+	out_reader->buffer_capacity = byte_count;
+	out_reader->buffer_size = byte_count;
+}
+
+static void file_reader_fill(File_Reader* reader, uint64 position)
+{
+	uint64 bytes_left_in_file = position < reader->file_size ? reader->file_size - position : 0;
+
+	reader->buffer_position = position;
+	reader->buffer_read_offset = 0;
+	reader->buffer_size = bytes_left_in_file < reader->buffer_capacity ? (uint32)bytes_left_in_file : reader->buffer_capacity;
+
+	if (reader->buffer_size)
+	{
+		file_read_at(reader->file, position, reader->buffer_size, reader->buffer);
+	}
+}
+
+void file_reader_read(File_Reader* reader, uint32 byte_count, void* bytes)
+{
+	uint8* bytes_iter = (uint8*)bytes;
+
+	while (byte_count)
+	{
+		uint32 bytes_in_buffer = reader->buffer_size - reader->buffer_read_offset;
+		if (!bytes_in_buffer)
+		{
+			// a memory reader's buffer is the whole file, so this is reading past the end of it
+			assert(reader->file);
+			if (!reader->file)
+			{
+				return;
+			}
+
+			uint64 position = reader->buffer_position + reader->buffer_size;
+
+			// big reads go straight into the destination rather than through the buffer
+			if (byte_count >= reader->buffer_capacity)
+			{
+				file_read_at(reader->file, position, byte_count, bytes_iter);
+				reader->buffer_position = position + byte_count;
+				reader->buffer_size = 0;
+				reader->buffer_read_offset = 0;
+				return;
+			}
+
+			file_reader_fill(reader, position);
+
+			bytes_in_buffer = reader->buffer_size;
+			assert(bytes_in_buffer);
+			if (!bytes_in_buffer)
+			{
+				return; // reading past the end of the file
+			}
+		}
+
+		uint32 bytes_to_copy = byte_count < bytes_in_buffer ? byte_count : bytes_in_buffer;
+		bytes_copy(bytes_iter, &reader->buffer[reader->buffer_read_offset], bytes_to_copy);
+
+		reader->buffer_read_offset += bytes_to_copy;
+		bytes_iter += bytes_to_copy;
+		byte_count -= bytes_to_copy;
+	}
+}
+
+int32 file_reader_read_i32(File_Reader* reader)
+{
+	int32 i32;
+	file_reader_read(reader, sizeof(i32), &i32);
+	return i32;
+}
+
+uint32 file_reader_read_u32(File_Reader* reader)
+{
+	uint32 u32;
+	file_reader_read(reader, sizeof(u32), &u32);
+	return u32;
+}
+
+uint16 file_reader_read_u16(File_Reader* reader)
+{
+	uint16 u16;
+	file_reader_read(reader, sizeof(u16), &u16);
+	return u16;
+}
+
+float32 file_reader_read_f32(File_Reader* reader)
+{
+	float32 f32;
+	file_reader_read(reader, sizeof(f32), &f32);
+	return f32;
+}
+
+Vec_3f file_reader_read_vec_3f(File_Reader* reader)
+{
+	Vec_3f v;
+	file_reader_read(reader, sizeof(float32) * 3, &v);
+	return v;
+}
+
+void file_reader_skip(File_Reader* reader, uint32 byte_count)
+{
+	file_reader_set_position(reader, file_reader_get_position(reader) + byte_count);
+}
+
+uint64 file_reader_get_position(File_Reader* reader)
+{
+	return reader->buffer_position + reader->buffer_read_offset;
+}
+
+// stays within the buffer if position is in it, otherwise the next read refills from position
+void file_reader_set_position(File_Reader* reader, uint64 position)
+{
+	if (position >= reader->buffer_position && position <= reader->buffer_position + reader->buffer_size)
+	{
+		reader->buffer_read_offset = (uint32)(position - reader->buffer_position);
+	}
+	else if (!reader->file)
+	{
+		// past the end of a memory reader, there's nothing to refill from so reads from here find nothing
+		reader->buffer_read_offset = reader->buffer_size;
+	}
+	else
+	{
+		reader->buffer_position = position;
+		reader->buffer_size = 0;
+		reader->buffer_read_offset = 0;
+	}
+}
+
+static void file_read_queue_lock(File_Read_Queue* queue)
+{
+	while (!atomic_compare_exchange(&queue->lock, /*new_value*/ 1, /*expected_value*/ 0))
+	{
+		thread_yield();
+	}
+}
+
+static void file_read_queue_unlock(File_Read_Queue* queue)
+{
+	atomic_exchange(&queue->lock, 0);
+}
+
+// returns null if the ring is empty
+static File_Read_Request* file_read_queue_pop(File_Read_Queue* queue)
+{
+	File_Read_Request* request = nullptr;
+
+	file_read_queue_lock(queue);
+	if (queue->head != queue->tail)
+	{
+		request = queue->requests[queue->head & (queue->capacity - 1)];
+		++queue->head;
+	}
+	file_read_queue_unlock(queue);
+
+	if (request)
+	{
+		semaphore_signal(queue->free_semaphore, 1);
+	}
+
+	return request;
+}
+
+// swapped into waiting_semaphore once the read is done, so a thread which starts waiting after that doesn't block
+constexpr int64 c_file_read_request_done = -1;
+
+static void file_read_request_do(File_Read_Request* request)
+{
+	file_read_at(request->file, request->position, request->byte_count, request->bytes);
+
+	// the request can be reused as soon as is_complete is set, so that has to be the last thing touched
+	int64 waiting_semaphore = atomic_exchange(&request->waiting_semaphore, c_file_read_request_done);
+	atomic_increment(&request->is_complete); // full barrier, so bytes are visible before is_complete is
+
+	if (waiting_semaphore)
+	{
+		semaphore_signal((Semaphore_Handle)(intptr_t)waiting_semaphore, 1);
+	}
+}
+
+static void file_read_queue_thread(void* state)
+{
+	File_Read_Queue* queue = (File_Read_Queue*)state;
+
+	while (true)
+	{
+		semaphore_wait(queue->pending_semaphore);
+
+		if (queue->is_shutting_down)
+		{
+			return;
+		}
+
+		// a waiting thread may have already taken the request this signal was for
+		File_Read_Request* request = file_read_queue_pop(queue);
+		if (request)
+		{
+			file_read_request_do(request);
+		}
+	}
+}
+
+void file_read_queue_create(File_Read_Queue* out_queue, int32 thread_count, uint32 capacity, Linear_Allocator* allocator)
+{
+	assert(thread_count > 0);
+	assert(capacity && (capacity & (capacity - 1)) == 0);
+
+	*out_queue = {};
+	out_queue->threads = (Thread_Handle*)linear_allocator_alloc(allocator, sizeof(Thread_Handle) * thread_count);
+	out_queue->thread_count = thread_count;
+	out_queue->requests = (File_Read_Request**)linear_allocator_alloc(allocator, sizeof(File_Read_Request*) * capacity);
+	out_queue->capacity = capacity;
+	out_queue->pending_semaphore = semaphore_create(/*initial_count*/ 0);
+	out_queue->free_semaphore = semaphore_create(/*initial_count*/ (int32)capacity);
+
+	for (int32 i = 0; i < thread_count; ++i)
+	{
+		out_queue->threads[i] = thread_create(file_read_queue_thread, out_queue);
+	}
+}
+
+// any requests still in the queue are not read
+void file_read_queue_destroy(File_Read_Queue* queue)
+{
+	queue->is_shutting_down = true;
+	semaphore_signal(queue->pending_semaphore, queue->thread_count);
+
+	for (int32 i = 0; i < queue->thread_count; ++i)
+	{
+		thread_join(queue->threads[i]);
+	}
+
+	semaphore_destroy(queue->pending_semaphore);
+	semaphore_destroy(queue->free_semaphore);
+}
+
+void file_read_submit(File_Read_Queue* queue, File_Read_Request* requests, uint32 request_count)
+{
+	for (uint32 i = 0; i < request_count; ++i)
+	{
+		requests[i].is_complete = false;
+		requests[i].waiting_semaphore = 0;
+	}
+
+	if (!queue)
+	{
+		for (uint32 i = 0; i < request_count; ++i)
+		{
+			file_read_request_do(&requests[i]);
+		}
+		return;
+	}
+
+	for (uint32 i = 0; i < request_count; ++i)
+	{
+		// blocks if the ring is full, until the reader threads catch up
+		semaphore_wait(queue->free_semaphore);
+
+		file_read_queue_lock(queue);
+		queue->requests[queue->tail & (queue->capacity - 1)] = &requests[i];
+		++queue->tail;
+		file_read_queue_unlock(queue);
+
+		semaphore_signal(queue->pending_semaphore, 1);
+	}
+}
+
+bool32 file_read_poll(File_Read_Request* requests, uint32 request_count)
+{
+	for (uint32 i = 0; i < request_count; ++i)
+	{
+		if (!requests[i].is_complete)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// the waiting thread does queued reads itself while there are any, this means any number of threads can wait on the 
+// same queue. Once the queue is empty it sleeps on a semaphore (one per call, only created if needed) which whichever 
+// thread finishes the read it's waiting on signals
+void file_read_wait(File_Read_Queue* queue, File_Read_Request* requests, uint32 request_count)
+{
+	Semaphore_Handle semaphore = nullptr;
+
+	for (uint32 i = 0; i < request_count; ++i)
+	{
+		while (!requests[i].is_complete)
+		{
+			File_Read_Request* request = queue ? file_read_queue_pop(queue) : nullptr;
+			if (request)
+			{
+				file_read_request_do(request);
+				continue;
+			}
+
+			if (!semaphore)
+			{
+				semaphore = semaphore_create(/*initial_count*/ 0);
+			}
+
+			// if this fails the read is finishing and is_complete is about to be set, otherwise the reader will see the 
+			// semaphore once it's done
+			if (atomic_compare_exchange(&requests[i].waiting_semaphore, /*new_value*/ (int64)(intptr_t)semaphore, /*expected_value*/ 0))
+			{
+				semaphore_wait(semaphore);
+			}
+			else
+			{
+				thread_yield();
+			}
+		}
+	}
+
+	if (semaphore)
+	{
+		semaphore_destroy(semaphore);
+	}
+}
+
+int32 file_read_i32(File_Handle file)
+{
+	int32 i32;
+	file_read(file, sizeof(i32), &i32);
+	return i32;
+}
+
+uint32 file_read_u32(File_Handle file)
+{
+	uint32 u32;
+	file_read(file, sizeof(u32), &u32);
+	return u32;
+}
+
+uint16 file_read_u16(File_Handle file)
+{
+	uint16 u16;
+	file_read(file, sizeof(u16), &u16);
+	return u16;
+}
+
+float32 file_read_f32(File_Handle file)
+{
+	float32 f32;
+	file_read(file, sizeof(f32), &f32);
+	return f32;
+}
+
+Vec_3f file_read_vec_3f(File_Handle file)
+{
+	Vec_3f v;
+	file_read(file, sizeof(float32) * 3, &v);
+	return v;
+}
+
+struct File_Search_Node
+{
+	char* path;
+	uint32 path_length;
+	File_Search_Node* next;
+};
+
+// each worker keeps its own lists and allocator, so nothing is shared while a level of directories is scanned
+struct File_Search_Worker
+{
+	Linear_Allocator allocator;
+	File_Search_Node* files;
+	uint32 file_count;
+	uint32 file_path_bytes; // incl nulls
+	File_Search_Node* dirs; // found in the current level
+	uint32 dir_count;
+	bool32 is_out_of_memory;
+};
+
+struct File_Search_State
+{
+	const char* search_term;
+	bool32 include_subdirs;
+	File_Search_Node** dirs; // to scan in the current level
+	File_Search_Worker* workers;
+};
+
+struct File_Search_Dir_State
+{
+	File_Search_State* search_state;
+	File_Search_Worker* worker;
+	File_Search_Node* dir;
+};
+
+static void file_search_on_dir_entry(const char* name, bool32 is_directory, void* state)
+{
+	File_Search_Dir_State* dir_state = (File_Search_Dir_State*)state;
+	File_Search_State* search_state = dir_state->search_state;
+	File_Search_Worker* worker = dir_state->worker;
+
+	// directories are only walked, files are only kept if they match, so there's no second pass for directories
+	if (is_directory ? !search_state->include_subdirs : !string_glob_match_ignore_case(name, search_state->search_term))
+	{
+		return;
+	}
+
+	File_Search_Node* dir = dir_state->dir;
+	uint32 name_length = string_length(name);
+
+	// anything which doesn't fit is left out, and the results are marked as truncated
+	uint32 path_length = dir->path_length + 1 + name_length;
+	if (sizeof(File_Search_Node) + path_length + 1 > worker->allocator.bytes_available)
+	{
+		worker->is_out_of_memory = true;
+		return;
+	}
+
+	File_Search_Node* node = (File_Search_Node*)linear_allocator_alloc(&worker->allocator, sizeof(File_Search_Node));
+	node->path_length = path_length;
+	node->path = (char*)linear_allocator_alloc(&worker->allocator, node->path_length + 1);
+	bytes_copy((uint8*)node->path, (uint8*)dir->path, dir->path_length);
+	node->path[dir->path_length] = '/';
+	bytes_copy((uint8*)&node->path[dir->path_length + 1], (const uint8*)name, name_length + 1);
+
+	if (is_directory)
+	{
+		node->next = worker->dirs;
+		worker->dirs = node;
+		++worker->dir_count;
+	}
+	else
+	{
+		node->next = worker->files;
+		worker->files = node;
+		++worker->file_count;
+		worker->file_path_bytes += node->path_length + 1;
+	}
+}
+
+static void file_search_scan_dir(uint32 item_index, int32 worker_index, void* state)
+{
+	File_Search_State* search_state = (File_Search_State*)state;
+
+	File_Search_Dir_State dir_state;
+	dir_state.search_state = search_state;
+	dir_state.worker = &search_state->workers[worker_index];
+	dir_state.dir = search_state->dirs[item_index];
+
+	dir_iterate(dir_state.dir->path, file_search_on_dir_entry, &dir_state);
+}
+
+// like file_search, but each level of sub directories is spread across thread_pool (optional) and only files are 
+// returned, in no particular order. search_term is a glob e.g. "*.pigg". Everything found is held in temp_allocator 
+// until the end, which is split between the workers. If either allocator runs out, out_results->is_truncated is set
+void file_search_parallel(
+	File_Search_Results* out_results, 
+	const char* dir_path, 
+	const char* search_term, 
+	bool32 include_subdirs, 
+	Thread_Pool* thread_pool, 
+	Linear_Allocator* allocator, 
+	Linear_Allocator* temp_allocator)
+{
+	Linear_Allocator temp = *temp_allocator;
+
+	int32 worker_count = thread_pool ? thread_pool->worker_count : 1;
+
+	*out_results = {};
+
+	// the workers get an equal share of what's left after their own state, and the rest is kept for the list 
+	// of directories in each level, give up straight away if that's nothing
+	uint32 workers_size = (uint32)(sizeof(File_Search_Worker) * worker_count);
+	if (workers_size >= temp.bytes_available || 
+		(temp.bytes_available - workers_size) / (worker_count + 1) < sizeof(File_Search_Node) + 2)
+	{
+		out_results->is_truncated = true;
+		return;
+	}
+
+	File_Search_State search_state = {};
+	search_state.search_term = search_term;
+	search_state.include_subdirs = include_subdirs;
+	search_state.workers = (File_Search_Worker*)linear_allocator_alloc(&temp, workers_size);
+
+	uint32 worker_allocator_size = temp.bytes_available / (worker_count + 1);
+	for (int32 i = 0; i < worker_count; ++i)
+	{
+		File_Search_Worker* worker = &search_state.workers[i];
+		*worker = {};
+		linear_allocator_create_sub_allocator(&temp, &worker->allocator, worker_allocator_size);
+	}
+
+	File_Search_Node root = {};
+	root.path = (char*)dir_path;
+	root.path_length = string_length(dir_path);
+
+	File_Search_Node* root_ptr = &root;
+	search_state.dirs = &root_ptr;
+	uint32 dir_count = 1;
+	bool32 is_truncated = false;
+
+	while (dir_count)
+	{
+		for (int32 i = 0; i < worker_count; ++i)
+		{
+			search_state.workers[i].dirs = nullptr;
+			search_state.workers[i].dir_count = 0;
+		}
+
+		if (thread_pool)
+		{
+			thread_pool_run(thread_pool, dir_count, file_search_scan_dir, &search_state);
+		}
+		else
+		{
+			for (uint32 i = 0; i < dir_count; ++i)
+			{
+				file_search_scan_dir(i, /*worker_index*/ 0, &search_state);
+			}
+		}
+
+		// gather up the sub directories everyone found for the next level
+		dir_count = 0;
+		for (int32 i = 0; i < worker_count; ++i)
+		{
+			dir_count += search_state.workers[i].dir_count;
+		}
+
+		if (dir_count && sizeof(File_Search_Node*) * dir_count > temp.bytes_available)
+		{
+			// no room to list the next level, so it isn't scanned
+			is_truncated = true;
+			dir_count = 0;
+		}
+
+		if (dir_count)
+		{
+			search_state.dirs = (File_Search_Node**)linear_allocator_alloc(&temp, sizeof(File_Search_Node*) * dir_count);
+
+			File_Search_Node** dir_iter = search_state.dirs;
+			for (int32 i = 0; i < worker_count; ++i)
+			{
+				for (File_Search_Node* dir = search_state.workers[i].dirs; dir; dir = dir->next)
+				{
+					*dir_iter++ = dir;
+				}
+			}
+		}
+	}
+
+	uint32 path_count = 0;
+	uint32 path_bytes = 0;
+	for (int32 i = 0; i < worker_count; ++i)
+	{
+		path_count += search_state.workers[i].file_count;
+		path_bytes += search_state.workers[i].file_path_bytes;
+		is_truncated |= search_state.workers[i].is_out_of_memory;
+	}
+
+	out_results->is_truncated = is_truncated;
+
+	// if the results themselves don't fit, there are none
+	if (path_count && (uint64)path_bytes + (sizeof(uint32) * (uint64)path_count) > allocator->bytes_available)
+	{
+		out_results->is_truncated = true;
+		return;
+	}
+
+	out_results->path_count = path_count;
+	if (path_count)
+	{
+		out_results->paths = (char*)linear_allocator_alloc(allocator, path_bytes);
+		out_results->path_offsets = (uint32*)linear_allocator_alloc(allocator, sizeof(uint32) * path_count);
+
+		uint32 path_index = 0;
+		uint32 path_offset = 0;
+		for (int32 i = 0; i < worker_count; ++i)
+		{
+			for (File_Search_Node* file = search_state.workers[i].files; file; file = file->next)
+			{
+				out_results->path_offsets[path_index++] = path_offset;
+				bytes_copy((uint8*)&out_results->paths[path_offset], (uint8*)file->path, file->path_length + 1);
+				path_offset += file->path_length + 1;
+			}
+		}
+	}
+}
+
+const char* file_search_result_path(File_Search_Results* results, uint32 index)
+{
+	assert(index < results->path_count);
+	return &results->paths[results->path_offsets[index]];
 }
\ No newline at end of file
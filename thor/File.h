@@ -2,26 +2,116 @@
 
 #include "Core.h"
 #include "Maths.h"
+#include "Thread.h"
 
 
 
-typedef void* File_Handle; // means that we don't have to include windows.h in this header
+typedef void* File_Handle; // means that we don't have to include windows.h in this header, on other platforms this is the file descriptor
 typedef void (*On_File_Found_Function)(const char* path, void* state);
 
+struct File_Mapping
+{
+	void* handle;
+	const uint8* bytes;
+	uint64 size;
+};
+
+// serves reads out of a buffer which is refilled a chunk at a time, so lots of small reads (e.g. parsing
+// a file a field at a time) don't each cost a syscall. Reads are positional, so the file's own position isn't used.
+// A reader can also be over bytes which are already in memory (e.g. a file read out of a pigg), then file is null 
+// and the buffer is the whole file
+struct File_Reader
+{
+	File_Handle file;
+	uint64 file_size;
+	uint8* buffer;
+	uint32 buffer_capacity;
+	uint32 buffer_size; // bytes currently in buffer
+	uint32 buffer_read_offset;
+	uint64 buffer_position; // position in the file of buffer[0]
+};
+
+// flat list of paths from file_search_parallel, all in one block of memory
+struct File_Search_Results
+{
+	char* paths; // null terminated paths back to back
+	uint32* path_offsets; // where each path starts in paths
+	uint32 path_count;
+	bool32 is_truncated; // temp memory ran out, so some matching files (or whole sub directories) are missing
+};
+
+struct File_Read_Request
+{
+	File_Handle file;
+	uint64 position;
+	uint32 byte_count;
+	void* bytes;
+	volatile int32 is_complete; // set by the queue once bytes has been filled
+	volatile int64 waiting_semaphore; // set by file_read_wait when it has to block on this request, signalled on completion
+};
+
+// reads are done by a few threads which just sit in file_read_at, so there can be many reads in flight at once,
+// requests are pointers to memory owned by the caller, which has to stay valid until the request completes
+struct File_Read_Queue
+{
+	Thread_Handle* threads;
+	int32 thread_count;
+	File_Read_Request** requests; // ring buffer, capacity is a power of 2
+	uint32 capacity;
+	uint32 head;
+	uint32 tail;
+	volatile int64 lock; // guards requests/head/tail
+	Semaphore_Handle pending_semaphore; // count of requests in the ring
+	Semaphore_Handle free_semaphore; // count of free slots in the ring
+	volatile int32 is_shutting_down;
+};
+
 File_Handle file_open_read(const char* path);
 File_Handle file_open_write(const char* path);
 void file_close(File_Handle file);
 bool file_is_valid(File_Handle file);
 void file_read(File_Handle file, uint32 byte_count, void* bytes);
+void file_read_at(File_Handle file, uint64 position, uint32 byte_count, void* bytes);
+void file_reader_create(File_Reader* out_reader, File_Handle file, uint8* buffer, uint32 buffer_capacity);
+void file_reader_create_from_memory(File_Reader* out_reader, const uint8* bytes, uint32 byte_count);
+void file_reader_read(File_Reader* reader, uint32 byte_count, void* bytes);
+int32 file_reader_read_i32(File_Reader* reader);
+uint32 file_reader_read_u32(File_Reader* reader);
+uint16 file_reader_read_u16(File_Reader* reader);
+float32 file_reader_read_f32(File_Reader* reader);
+Vec_3f file_reader_read_vec_3f(File_Reader* reader);
+void file_reader_skip(File_Reader* reader, uint32 byte_count);
+uint64 file_reader_get_position(File_Reader* reader);
+void file_reader_set_position(File_Reader* reader, uint64 position);
+void file_read_queue_create(File_Read_Queue* out_queue, int32 thread_count, uint32 capacity, struct Linear_Allocator* allocator);
+void file_read_queue_destroy(File_Read_Queue* queue);
+void file_read_submit(File_Read_Queue* queue, File_Read_Request* requests, uint32 request_count); // queue is optional, without one the reads are done before returning
+bool32 file_read_poll(File_Read_Request* requests, uint32 request_count);
+void file_read_wait(File_Read_Queue* queue, File_Read_Request* requests, uint32 request_count);
 int32 file_read_i32(File_Handle file);
-uint32 file_read_u32(File_Handle file); // todo(jbr) get rid of functions to read individual u32s etc, instead read chunk into buffer and read buffer
+uint32 file_read_u32(File_Handle file); // note: each of these is a syscall, use a File_Reader to parse a file a field at a time
 uint16 file_read_u16(File_Handle file);
 float32 file_read_f32(File_Handle file);
 Vec_3f file_read_vec_3f(File_Handle file);
 void file_skip(File_Handle file, uint32 byte_count);
-uint32 file_size(File_Handle file);
-uint32 file_get_position(File_Handle file);
-void file_set_position(File_Handle file, uint32 position);
-void file_write_bytes(File_Handle file, uint32 byte_count, void* bytes);
+uint64 file_size(File_Handle file);
+uint32 file_get_timestamp(File_Handle file);
+uint64 file_get_position(File_Handle file);
+void file_set_position(File_Handle file, uint64 position);
+void file_write_bytes(File_Handle file, uint32 byte_count, const void* bytes);
+bool file_mapping_open(File_Mapping* out_mapping, File_Handle file);
+void file_mapping_close(File_Mapping* mapping);
+void file_prefetch(File_Handle file, uint64 position, uint64 byte_count); // hint that a range will be read soon
+void file_mapping_prefetch(File_Mapping* mapping, uint64 offset, uint64 byte_count);
 void dir_create(const char* path);
-void file_search(const char* dir_path, const char* search_term, bool32 include_subdirs, On_File_Found_Function on_file_found, void* state);
\ No newline at end of file
+void file_delete(const char* path);
+void file_search(const char* dir_path, const char* search_term, bool32 include_subdirs, On_File_Found_Function on_file_found, void* state);
+void file_search_parallel(
+	File_Search_Results* out_results, 
+	const char* dir_path, 
+	const char* search_term, 
+	bool32 include_subdirs, 
+	Thread_Pool* thread_pool, 
+	Linear_Allocator* allocator, 
+	Linear_Allocator* temp_allocator);
+const char* file_search_result_path(File_Search_Results* results, uint32 index);
\ No newline at end of file
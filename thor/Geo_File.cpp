@@ -3,27 +3,132 @@
 #include <cmath>
 #include "Buffer.h"
 #include "Graphics.h"
+#include "Map.h"
 #include "Memory.h"
+#include "Pigg_File.h"
 #include "String.h"
+#include "Thread.h"
 #include "Zlib.h"
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define GEO_SSSE3 1
+#include <tmmintrin.h>
+#if _MSC_VER
+#include <intrin.h>
+#define GEO_SSSE3_FUNCTION
+#else
+#include <cpuid.h>
+#define GEO_SSSE3_FUNCTION __attribute__((target("ssse3")))
+#endif // _MSC_VER
+#else
+#define GEO_SSSE3 0
+#endif
 
 
-static uint8* geo_read_delta_compressed_data_from_file(File_Handle file, uint32 deflated_size, uint32 inflated_size, uint32 file_pos, Linear_Allocator* allocator)
+
+// below this a worker's share of temp memory for geo_catalog_dir wouldn't fit most geos' headers
+constexpr uint32 c_geo_catalog_min_worker_allocator_size = kilobytes(64);
+
+struct Geo_Catalog_Worker
+{
+	Linear_Allocator allocator; // catalogs, until they're copied out at the end
+	Linear_Allocator temp_allocator; // reset for each geo
+	Zlib_Inflate_Context inflate_context;
+};
+
+// for cataloging a directory of geos across a thread pool
+struct Geo_Catalog_State
 {
-	uint8* inflated = linear_allocator_alloc(allocator, inflated_size);
+	File_Search_Results* search_results;
+	Geo_Catalog* catalogs; // one per search result
+	Geo_Catalog_Result* catalog_results;
+	Geo_Catalog_Worker* workers;
+};
 
-	file_set_position(file, file_pos);
+struct Geo_Decode_Worker
+{
+	Linear_Allocator temp_allocator; // reset for each model
+	Zlib_Inflate_Context* inflate_context;
+};
+
+// for decoding a geo's models across a thread pool
+struct Geo_Decode_State
+{
+	Model* models;
+	int32 model_count;
+	Geo_Packed_Data* packed_data; // c_geo_stream_count per model
+	File_Read_Request* read_requests; // c_geo_stream_count per model
+	File_Read_Queue* read_queue;
+	Geo_Decode_Worker* workers;
+	volatile int32 corrupt_count;
+};
+
+// deflate can't do much better than ~1032:1, so a bigger inflated size than that means the size is corrupt
+static bool32 geo_is_inflated_size_plausible(uint32 deflated_size, uint32 inflated_size)
+{
+	return (uint64)inflated_size <= ((uint64)deflated_size * 1032) + 64;
+}
 
-	if (deflated_size)
+// for sizes which come from the file, so could be anything if it's corrupt. Returns null rather 
+// than asking the allocator for more than it has
+static uint8* geo_try_alloc(Linear_Allocator* allocator, uint64 size)
+{
+	if (size == 0 || size > allocator->bytes_available)
 	{
-		uint8* deflated = linear_allocator_alloc(allocator, deflated_size);
-		file_read(file, deflated_size, deflated);
-		zlib_inflate_bytes(deflated, deflated_size, inflated, inflated_size);
+		return nullptr;
 	}
-	else
+
+	return linear_allocator_alloc(allocator, (uint32)size);
+}
+
+// fills in a read request for the packed data, which is read into temp memory, deflated data still needs a geo_inflate_packed_data. 
+// For a geo in memory the request is already complete, with bytes pointing at the packed data. Returns false if the 
+// packed data isn't inside the file
+static bool32 geo_packed_data_read_request(const Geo_Source* source, Geo_Packed_Data* packed_data, uint32 packed_data_start, File_Read_Request* out_request, Linear_Allocator* allocator)
+{
+	uint32 size_in_file = packed_data->deflated_size ? packed_data->deflated_size : packed_data->inflated_size;
+
+	*out_request = {};
+	out_request->file = source->file;
+	out_request->position = (uint64)packed_data_start + packed_data->offset;
+	out_request->byte_count = size_in_file;
+	out_request->is_complete = source->file == nullptr;
+
+	// e.g. a stream the model doesn't have, or which wasn't asked for
+	if (!size_in_file)
+	{
+		return true;
+	}
+
+	if (out_request->position + size_in_file > source->size || 
+		(packed_data->deflated_size && !geo_is_inflated_size_plausible(packed_data->deflated_size, packed_data->inflated_size)))
+	{
+		return false;
+	}
+
+	if (!source->file)
+	{
+		out_request->bytes = (void*)&source->bytes[out_request->position];
+		return true;
+	}
+
+	out_request->bytes = geo_try_alloc(allocator, size_in_file);
+	return out_request->bytes != nullptr;
+}
+
+// null if the data is corrupt
+static uint8* geo_inflate_packed_data(Geo_Packed_Data* packed_data, File_Read_Request* request, Zlib_Inflate_Context* inflate_context, Linear_Allocator* allocator)
+{
+	if (!packed_data->deflated_size)
+	{
+		return (uint8*)request->bytes;
+	}
+
+	uint8* inflated = geo_try_alloc(allocator, packed_data->inflated_size);
+	if (!inflated || 
+		zlib_inflate_bytes_checked(inflate_context, (uint8*)request->bytes, packed_data->deflated_size, inflated, packed_data->inflated_size) != Zlib_Result::Ok)
 	{
-		file_read(file, inflated_size, inflated);
+		return nullptr;
 	}
 
 	return inflated;
@@ -37,71 +142,277 @@ static uint8 geo_read_delta_bits(uint8* buffer, uint32 bit_offset)
 	return (byte >> bit_offset_in_byte) & 3;
 }
 
-static uint32* geo_unpack_delta_compressed_triangles(File_Handle file, uint32 deflated_data_size, uint32 inflated_data_size, uint32 file_pos, uint32* triangles, uint32 triangle_count, Linear_Allocator* temp_allocator)
+// bytes used by a value, indexed by its delta bits
+static const uint32 c_delta_value_sizes[4] = { 0, 1, 2, 4 };
+
+#if GEO_SSSE3
+// everything needed to decode the 4 values whose delta bits are in one byte
+struct Geo_Delta_Decode_Entry
+{
+	uint8 shuffle[16]; // moves each value's bytes into its own 32 bit lane, zero extended
+	int32 bias[4]; // added to a gathered value to get a triangle delta, one less for a float delta
+	int32 is_raw[4]; // all bits set where the value is a raw float32 rather than scaled
+	uint32 value_bytes; // how far the 4 values move through the value bytes
+};
+
+static Geo_Delta_Decode_Entry* create_delta_decode_table()
+{
+	static Geo_Delta_Decode_Entry table[256];
+
+	static const int32 c_triangle_bias[4] = { 1, -126, -32766, 1 };
+
+	for (uint32 delta_bits_byte = 0; delta_bits_byte < 256; ++delta_bits_byte)
+	{
+		Geo_Delta_Decode_Entry* entry = &table[delta_bits_byte];
+
+		uint32 value_bytes = 0;
+		for (uint32 lane = 0; lane < 4; ++lane)
+		{
+			uint32 delta_bits = (delta_bits_byte >> (lane * 2)) & 3;
+			uint32 value_size = c_delta_value_sizes[delta_bits];
+
+			for (uint32 i = 0; i < 4; ++i)
+			{
+				// top bit set makes the shuffle write a zero
+				entry->shuffle[(lane * 4) + i] = i < value_size ? (uint8)(value_bytes + i) : 0x80;
+			}
+
+			entry->bias[lane] = c_triangle_bias[delta_bits];
+			entry->is_raw[lane] = delta_bits == 3 ? -1 : 0;
+
+			value_bytes += value_size;
+		}
+
+		entry->value_bytes = value_bytes;
+	}
+
+	return table;
+}
+
+static bool32 cpu_has_ssse3()
+{
+	uint32 ecx;
+#if _MSC_VER
+	int32 cpu_info[4];
+	__cpuid(cpu_info, 1);
+	ecx = (uint32)cpu_info[2];
+#else
+	uint32 eax, ebx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+	{
+		return false;
+	}
+#endif
+
+	return (ecx >> 9) & 1;
+}
+
+static Geo_Delta_Decode_Entry* s_delta_decode_table = create_delta_decode_table();
+static bool32 s_has_ssse3 = cpu_has_ssse3();
+
+// decodes 4 values per byte of delta bits, for as long as there are 16 value bytes left (the most 4 values can use) 
+// so every load is in bounds, the rest is left for the scalar decode. Each value is the value 3 before it plus its 
+// delta, so for a group of 4 lanes 0-2 add on lanes 1-3 of the previous group, then lane 3 adds on lane 0
+GEO_SSSE3_FUNCTION static bool32 geo_unpack_delta_triangles_ssse3(
+	uint8* delta_bits_section, 
+	uint8* value_section_end, 
+	uint32 vertex_count, 
+	uint32* triangles, 
+	uint32 value_count, 
+	uint32* inout_value_i, 
+	uint8** inout_src)
+{
+	uint8* src = *inout_src;
+	uint32 delta_bits_byte_count = value_count / 4;
+	uint32 delta_bits_byte_i = 0;
+
+	// no unsigned compare, so flip the sign bits and do a signed one, vertex_count is never 0 here
+	__m128i sign_bit = _mm_set1_epi32((int32)0x80000000);
+	__m128i max_index = _mm_xor_si128(_mm_set1_epi32((int32)(vertex_count - 1)), sign_bit);
+	__m128i is_out_of_range = _mm_setzero_si128();
+	__m128i previous = _mm_setzero_si128();
+
+	while (delta_bits_byte_i < delta_bits_byte_count && (value_section_end - src) >= 16)
+	{
+		Geo_Delta_Decode_Entry* entry = &s_delta_decode_table[delta_bits_section[delta_bits_byte_i]];
+
+		__m128i values = _mm_shuffle_epi8(_mm_loadu_si128((__m128i*)src), _mm_loadu_si128((__m128i*)entry->shuffle));
+		__m128i deltas = _mm_add_epi32(values, _mm_loadu_si128((__m128i*)entry->bias));
+
+		__m128i indices = _mm_add_epi32(deltas, _mm_srli_si128(previous, 4));
+		indices = _mm_add_epi32(indices, _mm_slli_si128(indices, 12));
+
+		_mm_storeu_si128((__m128i*)&triangles[delta_bits_byte_i * 4], indices);
+
+		// checked once at the end, rather than a branch for every group
+		is_out_of_range = _mm_or_si128(is_out_of_range, _mm_cmpgt_epi32(_mm_xor_si128(indices, sign_bit), max_index));
+
+		previous = indices;
+		src += entry->value_bytes;
+		++delta_bits_byte_i;
+	}
+
+	*inout_value_i = delta_bits_byte_i * 4;
+	*inout_src = src;
+
+	return _mm_movemask_epi8(is_out_of_range) == 0;
+}
+
+// as geo_unpack_delta_triangles_ssse3, but values are floats and components_per_item is 2 or 3
+GEO_SSSE3_FUNCTION static void geo_unpack_delta_floats_ssse3(
+	uint8* delta_bits_section, 
+	uint8* value_section_end, 
+	float32 scale, 
+	uint32 components_per_item, 
+	float32* floats, 
+	uint32 value_count, 
+	uint32* inout_value_i, 
+	uint8** inout_src)
 {
-	if (inflated_data_size)
+	uint8* src = *inout_src;
+	uint32 delta_bits_byte_count = value_count / 4;
+	uint32 delta_bits_byte_i = 0;
+
+	__m128 scale_4 = _mm_set1_ps(scale);
+	__m128i one = _mm_set1_epi32(1);
+	__m128 previous = _mm_setzero_ps();
+
+	while (delta_bits_byte_i < delta_bits_byte_count && (value_section_end - src) >= 16)
 	{
-		uint8* delta_compressed_data = geo_read_delta_compressed_data_from_file(file, deflated_data_size, inflated_data_size, file_pos, temp_allocator);
+		Geo_Delta_Decode_Entry* entry = &s_delta_decode_table[delta_bits_section[delta_bits_byte_i]];
+
+		__m128i values = _mm_shuffle_epi8(_mm_loadu_si128((__m128i*)src), _mm_loadu_si128((__m128i*)entry->shuffle));
+		__m128i scaled_values = _mm_add_epi32(values, _mm_sub_epi32(_mm_loadu_si128((__m128i*)entry->bias), one));
+		__m128 scaled_deltas = _mm_mul_ps(_mm_cvtepi32_ps(scaled_values), scale_4);
+
+		__m128i is_raw = _mm_loadu_si128((__m128i*)entry->is_raw);
+		__m128 deltas = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(is_raw, values), _mm_andnot_si128(is_raw, _mm_castps_si128(scaled_deltas))));
+
+		__m128 items;
+		if (components_per_item == 3)
+		{
+			items = _mm_add_ps(deltas, _mm_castsi128_ps(_mm_srli_si128(_mm_castps_si128(previous), 4)));
+			items = _mm_add_ps(items, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(items), 12)));
+		}
+		else
+		{
+			items = _mm_add_ps(deltas, _mm_castsi128_ps(_mm_srli_si128(_mm_castps_si128(previous), 8)));
+			items = _mm_add_ps(items, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(items), 8)));
+		}
+
+		_mm_storeu_ps(&floats[delta_bits_byte_i * 4], items);
+
+		previous = items;
+		src += entry->value_bytes;
+		++delta_bits_byte_i;
+	}
 
+	*inout_value_i = delta_bits_byte_i * 4;
+	*inout_src = src;
+}
+#endif // GEO_SSSE3
+
+// returns false if the data is corrupt, i.e. too short for the number of triangles, or has indices past vertex_count
+static bool32 geo_unpack_delta_compressed_triangles(uint8* delta_compressed_data, uint32 delta_compressed_data_size, uint32* triangles, uint32 triangle_count, uint32 vertex_count)
+{
+	if (delta_compressed_data)
+	{
 		uint8* delta_bits_section = delta_compressed_data;
-		uint32 delta_bits_count = triangle_count * 3 * 2; // 2 bits per value, 3 values per triangle
-		uint32 delta_bits_section_size = (delta_bits_count + 7) / 8; // round up to nearest byte
+		uint64 delta_bits_count = (uint64)triangle_count * 3 * 2; // 2 bits per value, 3 values per triangle
+		uint64 delta_bits_section_size = (delta_bits_count + 7) / 8; // round up to nearest byte
+
+		if (delta_bits_section_size + 1 > delta_compressed_data_size || (triangle_count && !vertex_count))
+		{
+			return false;
+		}
 
 		uint8* triangle_section = delta_bits_section + delta_bits_section_size + 1; // skip the scale byte, not used
+		uint8* triangle_section_end = delta_compressed_data + delta_compressed_data_size;
 		
-		int32 triangle[3] = { 0, 0, 0 };
-		uint32 delta_bits_offset = 0;
+		uint32 value_count = triangle_count * 3;
+		uint32 value_i = 0;
 		uint8* src_iter = triangle_section;
-		uint32* dst_iter = triangles;
+		int32 triangle[3] = { 0, 0, 0 };
 
-		for (uint32 triangle_i = 0; triangle_i < triangle_count; ++triangle_i)
+#if GEO_SSSE3
+		if (s_has_ssse3)
 		{
-			for (uint32 component_i = 0; component_i < 3; ++component_i)
+			if (!geo_unpack_delta_triangles_ssse3(delta_bits_section, triangle_section_end, vertex_count, triangles, value_count, &value_i, &src_iter))
 			{
-				uint8 delta_bits = geo_read_delta_bits(delta_bits_section, delta_bits_offset);
-				delta_bits_offset += 2;
+				return false;
+			}
 
-				switch (delta_bits)
-				{
-				case 0:
-					++triangle[component_i];
-					break;
+			// carry on from where the vector decode got to
+			for (uint32 i = value_i < 3 ? value_i : 3; i > 0; --i)
+			{
+				triangle[(value_i - i) % 3] = triangles[value_i - i];
+			}
+		}
+#endif // GEO_SSSE3
 
-				case 1: 
-					triangle[component_i] += buffer_read_u8(&src_iter) - 126;
-					break; 
+		uint32 component_i = value_i % 3;
+		uint32* dst_iter = &triangles[value_i];
 
-				case 2: 
-					triangle[component_i] += buffer_read_u16(&src_iter) - 32766;
-					break; 
+		for (; value_i < value_count; ++value_i)
+		{
+			uint8 delta_bits = geo_read_delta_bits(delta_bits_section, value_i * 2);
 
-				case 3: 
-					triangle[component_i] += buffer_read_i32(&src_iter) + 1;
-					break; 
-				}
+			// one check per value rather than per read, for good data it's never taken
+			if (c_delta_value_sizes[delta_bits] > (uint32)(triangle_section_end - src_iter))
+			{
+				return false;
+			}
+
+			switch (delta_bits)
+			{
+			case 0:
+				++triangle[component_i];
+				break;
+
+			case 1: 
+				triangle[component_i] += buffer_read_u8(&src_iter) - 126;
+				break; 
 
-				assert(triangle[component_i] >= 0);
+			case 2: 
+				triangle[component_i] += buffer_read_u16(&src_iter) - 32766;
+				break; 
 
-				*dst_iter = triangle[component_i];
-				++dst_iter;
+			case 3: 
+				triangle[component_i] += buffer_read_i32(&src_iter) + 1;
+				break; 
+			}
+
+			// negative indices wrap around to something too big
+			if ((uint32)triangle[component_i] >= vertex_count)
+			{
+				return false;
 			}
-		}
 
-		return triangles;
+			*dst_iter = triangle[component_i];
+			++dst_iter;
+
+			component_i = component_i == 2 ? 0 : component_i + 1;
+		}
 	}
 	
-	return nullptr;
+	return true;
 }
 
-static float32* geo_unpack_delta_compressed_floats(File_Handle file, uint32 deflated_data_size, uint32 inflated_data_size, uint32 file_pos, float32* floats, uint32 item_count, uint32 components_per_item, Linear_Allocator* temp_allocator)
+// returns false if the data is too short for the number of items
+static bool32 geo_unpack_delta_compressed_floats(uint8* delta_compressed_data, uint32 delta_compressed_data_size, float32* floats, uint32 item_count, uint32 components_per_item)
 {
-	if (inflated_data_size)
+	assert(components_per_item <= 3);
+
+	if (delta_compressed_data)
 	{
-		uint8* delta_compressed_data = geo_read_delta_compressed_data_from_file(file, deflated_data_size, inflated_data_size, file_pos, temp_allocator);
-		
 		uint8* delta_bits_section = delta_compressed_data;
-		uint32 delta_bits_count = item_count * components_per_item * 2; // 2 bits per value
-		uint32 delta_bits_section_size = (delta_bits_count + 7) / 8; // round up to nearest byte
+		uint64 delta_bits_count = (uint64)item_count * components_per_item * 2; // 2 bits per value
+		uint64 delta_bits_section_size = (delta_bits_count + 7) / 8; // round up to nearest byte
+
+		if (delta_bits_section_size + 1 > delta_compressed_data_size)
+		{
+			return false;
+		}
 
 		uint8* scale_section = delta_compressed_data + delta_bits_section_size;
 		float32 inv_scale = (float32)(1 << *scale_section);
@@ -112,67 +423,99 @@ static float32* geo_unpack_delta_compressed_floats(File_Handle file, uint32 defl
 		}
 
 		uint8* value_section = scale_section + 1;
+		uint8* value_section_end = delta_compressed_data + delta_compressed_data_size;
 
-		float32 item[3] = { 0.0f, 0.0f, 0.0f };
-		uint32 delta_bits_offset = 0;
+		uint32 value_count = item_count * components_per_item;
+		uint32 value_i = 0;
 		uint8* src_iter = value_section;
-		float32* dst_iter = floats;
+		float32 item[3] = { 0.0f, 0.0f, 0.0f };
 
-		for (uint32 item_i = 0; item_i < item_count; ++item_i)
+#if GEO_SSSE3
+		if (s_has_ssse3 && (components_per_item == 2 || components_per_item == 3))
 		{
-			for (uint32 component_i = 0; component_i < components_per_item; ++component_i)
+			geo_unpack_delta_floats_ssse3(delta_bits_section, value_section_end, scale, components_per_item, floats, value_count, &value_i, &src_iter);
+
+			// carry on from where the vector decode got to
+			for (uint32 i = value_i < components_per_item ? value_i : components_per_item; i > 0; --i)
 			{
-				uint8 delta_bits = geo_read_delta_bits(delta_bits_section, delta_bits_offset);
-				delta_bits_offset += 2;
+				item[(value_i - i) % components_per_item] = floats[value_i - i];
+			}
+		}
+#endif // GEO_SSSE3
 
-				switch (delta_bits)
-				{
-				case 0:
-					break;
+		uint32 component_i = value_i % components_per_item;
+		float32* dst_iter = &floats[value_i];
 
-				case 1:
-					item[component_i] += (float32)(buffer_read_u8(&src_iter) - 127) * scale;
-					break;
+		for (; value_i < value_count; ++value_i)
+		{
+			uint8 delta_bits = geo_read_delta_bits(delta_bits_section, value_i * 2);
 
-				case 2:
-					item[component_i] += (float32)(buffer_read_u16(&src_iter) - 32767) * scale;
-					break;
+			// one check per value rather than per read, for good data it's never taken
+			if (c_delta_value_sizes[delta_bits] > (uint32)(value_section_end - src_iter))
+			{
+				return false;
+			}
 
-				case 3:
-					uint32 u_value = buffer_read_u32(&src_iter);
-					item[component_i] += *(float32*)&u_value;
-					break;
-				}
+			switch (delta_bits)
+			{
+			case 0:
+				break;
+
+			case 1:
+				item[component_i] += (float32)(buffer_read_u8(&src_iter) - 127) * scale;
+				break;
 
-				assert(!isnan(item[component_i]));
-				assert(!isinf(item[component_i]));
+			case 2:
+				item[component_i] += (float32)(buffer_read_u16(&src_iter) - 32767) * scale;
+				break;
 
-				*dst_iter = item[component_i];
-				++dst_iter;
+			case 3:
+				uint32 u_value = buffer_read_u32(&src_iter);
+				item[component_i] += *(float32*)&u_value;
+				break;
 			}
+
+			*dst_iter = item[component_i];
+			++dst_iter;
+
+			component_i = component_i + 1 == components_per_item ? 0 : component_i + 1;
 		}
 
-		return floats;
+		// checked after rather than as each value is decoded, as the vector decode doesn't stop for them
+		for (uint32 i = 0; i < value_count; ++i)
+		{
+			assert(!std::isnan(floats[i]));
+			assert(!std::isinf(floats[i]));
+		}
 	}
 	
-	return nullptr;
+	return true;
 }
 
-void geo_file_read(
-	File_Handle file, 
-	const char** model_names, 
-	Model* out_models, 
-	int32 model_count, 
-	Linear_Allocator* allocator, 
-	Linear_Allocator* temp_allocator)
+void geo_source_create(Geo_Source* out_source, File_Handle file)
 {
-	int32* model_indices = (int32*)linear_allocator_alloc(temp_allocator, sizeof(int32) * model_count);
-	for (int32 i = 0; i < model_count; ++i)
-	{
-		model_indices[i] = -1;
-	}
+	*out_source = {};
+	out_source->file = file;
+	out_source->size = file_size(file);
+}
 
-	uint32 header_size = file_read_u32(file);
+void geo_source_create_from_memory(Geo_Source* out_source, const uint8* bytes, uint64 size)
+{
+	*out_source = {};
+	out_source->bytes = bytes;
+	out_source->size = size;
+}
+
+// bytes is the start of a .geo file, up to at least the end of the compressed header data, this could be 
+// read from disk or come from the file header table of a pigg. Returns false if the header is corrupt
+bool32 geo_header_read(Geo_Header* out_header, const uint8* bytes, uint32 byte_count, Zlib_Inflate_Context* inflate_context, Linear_Allocator* allocator)
+{
+	*out_header = {};
+
+	Buffer_Reader file_reader;
+	buffer_reader_create(&file_reader, bytes, byte_count);
+
+	uint32 header_size = buffer_reader_read_u32(&file_reader);
 
 	// determine version of .geo format
 	uint32 deflated_header_size;
@@ -181,11 +524,11 @@ void geo_file_read(
 
 	// in versions > 0, the second u32 will be 0, followed by a u32 version number
 	// in version 0, inflated header data size follows the header size field
-	uint32 field_2 = file_read_u32(file);
+	uint32 field_2 = buffer_reader_read_u32(&file_reader);
 	if (field_2 == 0)
 	{
-		version = file_read_u32(file);
-		inflated_header_size = file_read_u32(file);
+		version = buffer_reader_read_u32(&file_reader);
+		inflated_header_size = buffer_reader_read_u32(&file_reader);
 		deflated_header_size = header_size - 12;
 	}
 	else
@@ -195,50 +538,58 @@ void geo_file_read(
 		deflated_header_size = header_size - 4;
 	}
 
-	uint8* deflated_header_bytes = linear_allocator_alloc(temp_allocator, deflated_header_size);
-	uint8* inflated_header_bytes = linear_allocator_alloc(temp_allocator, inflated_header_size);
-
-	file_read(file, deflated_header_size, deflated_header_bytes);
-	uint32 file_end_of_header_pos = file_get_position(file); file_end_of_header_pos;
-
-	uint32 bytes_inflated = zlib_inflate_bytes(deflated_header_bytes, deflated_header_size, inflated_header_bytes, inflated_header_size);
-	assert(bytes_inflated == inflated_header_size);
+	// a header_size too small for the fields above wraps around, so fails this too
+	const uint8* deflated_header_bytes = buffer_reader_read_bytes(&file_reader, deflated_header_size);
+	if (!deflated_header_bytes)
+	{
+		return false;
+	}
 
 	// I24 contains geos of version 0, 2, 3, 4, 5, 7, 8
-	assert(version != 1 && version != 6 && version <= 8);
+	if (version == 1 || version == 6 || version > 8)
+	{
+		return false;
+	}
 
-	uint8* header = inflated_header_bytes;
+	uint8* inflated_header_bytes = geo_is_inflated_size_plausible(deflated_header_size, inflated_header_size) ? geo_try_alloc(allocator, inflated_header_size) : nullptr;
+	if (!inflated_header_bytes || 
+		zlib_inflate_bytes_checked(inflate_context, deflated_header_bytes, deflated_header_size, inflated_header_bytes, inflated_header_size) != Zlib_Result::Ok)
+	{
+		return false;
+	}
+
+	Buffer_Reader header_reader;
+	buffer_reader_create(&header_reader, inflated_header_bytes, inflated_header_size);
 
 	// info
-	buffer_skip(&header, 4); // geo data size (think this is combined tris/verts/normals/uvs/etc
-	uint32 texture_names_section_size = buffer_read_u32(&header);
-	uint32 model_names_section_size = buffer_read_u32(&header);
-	uint32 texture_binds_section_size = buffer_read_u32(&header);
+	buffer_reader_skip(&header_reader, 4); // geo data size (think this is combined tris/verts/normals/uvs/etc
+	uint32 texture_names_section_size = buffer_reader_read_u32(&header_reader);
+	uint32 model_names_section_size = buffer_reader_read_u32(&header_reader);
+	uint32 texture_binds_section_size = buffer_reader_read_u32(&header_reader);
 	uint32 lod_section_size;
 	if (version >= 2 && version <= 5)
 	{
-		lod_section_size = buffer_read_u32(&header);
+		lod_section_size = buffer_reader_read_u32(&header_reader);
 	}
 	else
 	{
 		lod_section_size = 0;
 	}
 
-	header += texture_names_section_size;
+	buffer_reader_skip(&header_reader, texture_names_section_size);
 
-	uint8* model_names_section = header;
-	
-	header += model_names_section_size;
-	header += texture_binds_section_size;
-	header += lod_section_size;
+	const uint8* model_names_section = buffer_reader_read_bytes(&header_reader, model_names_section_size);
 
-	buffer_skip(&header, 124); // geo name
+	buffer_reader_skip(&header_reader, texture_binds_section_size);
+	const uint8* lod_section = buffer_reader_read_bytes(&header_reader, lod_section_size);
 
-	buffer_skip(&header, 12);
+	buffer_reader_skip(&header_reader, 124); // geo name
+
+	buffer_reader_skip(&header_reader, 12);
 	
-	int32 geo_model_count = buffer_read_i32(&header);
+	int32 geo_model_count = buffer_reader_read_i32(&header_reader);
 
-	uint8* models_section = header;
+	const uint8* models_section = &inflated_header_bytes[header_reader.position];
 
 	int32 bytes_per_model_header = 0;
 	switch (version)
@@ -267,143 +618,1075 @@ void geo_file_read(
 		break;
 	}
 
-	for (int32 model_i = 0; model_i < geo_model_count; ++model_i)
+	// every model header has to be there, and the names section has to end in a null so no name can run off the end of it
+	if (header_reader.is_overrun || 
+		geo_model_count < 0 || 
+		(uint64)geo_model_count * bytes_per_model_header > buffer_reader_bytes_remaining(&header_reader) || 
+		(model_names_section_size && model_names_section[model_names_section_size - 1]))
 	{
-		uint8* model_header = models_section + (model_i * bytes_per_model_header);
+		return false;
+	}
 
-		const char* model_name = nullptr;
+	out_header->version = version;
+	out_header->model_names_section = (uint8*)model_names_section;
+	out_header->model_names_section_size = model_names_section_size;
+	out_header->models_section = (uint8*)models_section;
+	out_header->model_count = geo_model_count;
+	out_header->bytes_per_model_header = bytes_per_model_header;
 
-		switch (version)
-		{
-		case 0:
-		case 2:
-			model_name = (const char*)&model_names_section[*(uint32*)&model_header[80]];
-			break;
+	// lods are only extra information, so a geo with a lod section too small for its models still loads, just without them
+	if (lod_section_size && (uint64)geo_model_count * sizeof(Geo_Model_Lods) <= lod_section_size)
+	{
+		out_header->model_lods = (Geo_Model_Lods*)lod_section;
+	}
 
-		case 3:
-		case 4:
-		case 5:
-		case 7:
-			model_name = (const char*)&model_names_section[*(uint32*)&model_header[60]];
-			break;
+	// the packed mesh data starts right after the compressed header (with 4 unknown bytes in between in version 0)
+	out_header->packed_data_offset = header_size + 4;
+	if (version == 0)
+	{
+		out_header->packed_data_offset += 4;
+	}
 
-		case 8:
-			model_name = (const char*)&model_names_section[*(uint32*)&model_header[64]];
-			break;
+	return true;
+}
 
-		default:
-			assert(false);
-			break;
-		}
+// the lod a model should use at this distance, the first one which isn't too far away, or the coarsest if they all are
+int32 geo_lod_select(const Geo_Model_Lods* model_lods, float32 distance)
+{
+	// used_lod_count isn't trusted either
+	int32 lod_count = (int32)model_lods->used_lod_count;
+	lod_count = lod_count < 1 ? 1 : (lod_count > c_geo_max_lods ? c_geo_max_lods : lod_count);
 
-		// model name often has trick appended e.g. model_name__trick_name
-		char temp_model_name[64];
-		int32 trick_start_index = string_find_last(model_name, "__");
-		if (trick_start_index > -1)
+	for (int32 i = 0; i < lod_count - 1; ++i)
+	{
+		if (distance < model_lods->lods[i].far_distance)
 		{
-			string_copy(temp_model_name, sizeof(temp_model_name), model_name, trick_start_index);
-			model_name = temp_model_name;
+			return i;
 		}
+	}
 
-		for (int32 model_name_i = 0; model_name_i < model_count; ++model_name_i)
-		{
-			if (string_equals(model_name, model_names[model_name_i]))
-			{
-				model_indices[model_name_i] = model_i;
-				break;
-			}
-		}
+	return lod_count - 1;
+}
+
+// if a model name (with any trick already stripped) ends in _LOD<n> this returns n, and the length of the name without 
+// it, otherwise it's lod 0. This naming is an assumption, documentation/geo_file_format.md only describes the lod 
+// distances and not how a model's lods are found
+static int32 geo_model_name_lod(const char* model_name, int32 model_name_length, int32* out_base_name_length)
+{
+	*out_base_name_length = model_name_length;
+
+	const int32 c_suffix_length = 5; // _LOD<n>
+	if (model_name_length <= c_suffix_length)
+	{
+		return 0;
 	}
 
-	for (int32 i = 0; i < model_count; ++i)
+	const char* suffix = &model_name[model_name_length - c_suffix_length];
+	int32 lod = suffix[4] - '0';
+	if (!string_equals_ignore_case("_lod", suffix, 4) || lod < 1 || lod >= c_geo_max_lods)
+	{
+		return 0;
+	}
+
+	*out_base_name_length = model_name_length - c_suffix_length;
+	return lod;
+}
+
+// note: model name may have a trick appended e.g. model_name__trick_name. Null if the header has a bad offset for it
+const char* geo_header_model_name(Geo_Header* header, int32 model_index)
+{
+	assert(model_index >= 0 && model_index < header->model_count);
+
+	uint8* model_header = header->models_section + (model_index * header->bytes_per_model_header);
+
+	uint32 name_offset;
+	switch (header->version)
 	{
-		assert(model_indices[i] > -1);
+	case 0:
+	case 2:
+		name_offset = *(uint32*)&model_header[80];
+		break;
 
-		uint8* model_header = models_section + (model_indices[i] * bytes_per_model_header);
+	case 3:
+	case 4:
+	case 5:
+	case 7:
+		name_offset = *(uint32*)&model_header[60];
+		break;
 
-		uint32	model_vertex_count = 0;
-		uint32	model_triangle_count = 0;
-		uint32	deflated_triangle_data_size = 0; // todo(jbr) make these a structure
-		uint32	inflated_triangle_data_size = 0;
-		uint32	triangle_data_offset = 0;
-		uint32	deflated_vertex_data_size = 0;
-		uint32	inflated_vertex_data_size = 0;
-		uint32	vertex_data_offset = 0;
-		
-		switch (version)
-		{
-		case 0:
-		case 2:
-			model_vertex_count = *(uint32*)&model_header[28];
-			model_triangle_count = *(uint32*)&model_header[32];
-			deflated_triangle_data_size = *(uint32*)&model_header[132];
-			inflated_triangle_data_size = *(uint32*)&model_header[136];
-			triangle_data_offset = *(uint32*)&model_header[140];
-			deflated_vertex_data_size = *(uint32*)&model_header[144];
-			inflated_vertex_data_size = *(uint32*)&model_header[148];
-			vertex_data_offset = *(uint32*)&model_header[152];
-			break;
+	case 8:
+		name_offset = *(uint32*)&model_header[64];
+		break;
 
-		case 3:
-		case 4:
-		case 5:
-		case 7:
-			model_vertex_count = *(uint32*)&model_header[16];
-			model_triangle_count = *(uint32*)&model_header[20];
-			deflated_triangle_data_size = *(uint32*)&model_header[104];
-			inflated_triangle_data_size = *(uint32*)&model_header[108];
-			triangle_data_offset = *(uint32*)&model_header[112];
-			deflated_vertex_data_size = *(uint32*)&model_header[116];
-			inflated_vertex_data_size = *(uint32*)&model_header[120];
-			vertex_data_offset = *(uint32*)&model_header[124];
-			break;
+	default:
+		assert(false);
+		return nullptr;
+	}
 
-		case 8:
-			model_vertex_count = *(uint32*)&model_header[16];
-			model_triangle_count = *(uint32*)&model_header[20];
-			deflated_triangle_data_size = *(uint32*)&model_header[108];
-			inflated_triangle_data_size = *(uint32*)&model_header[112];
-			triangle_data_offset = *(uint32*)&model_header[116];
-			deflated_vertex_data_size = *(uint32*)&model_header[120];
-			inflated_vertex_data_size = *(uint32*)&model_header[124];
-			vertex_data_offset = *(uint32*)&model_header[128];
-			break;
+	// the names section always ends in a null, so any offset inside it is a valid string
+	if (name_offset >= header->model_names_section_size)
+	{
+		return nullptr;
+	}
 
-		default:
-			assert(false);
-			break;
-		}
+	return (const char*)&header->model_names_section[name_offset];
+}
 
-		uint32	file_start_of_packed_data_pos = file_end_of_header_pos;
-		if (version == 0)
-		{
-			file_start_of_packed_data_pos += 4;
-		}
+// for interleaved models, copies each item of a stream decoded into a tightly packed buffer into its place in each vertex
+static void geo_interleave_stream(const uint8* items, uint32 item_size, uint32 item_count, uint8* dst, uint32 vertex_stride)
+{
+	for (uint32 i = 0; i < item_count; ++i)
+	{
+		bytes_copy(dst, items, item_size);
 
-		Model* model = &out_models[i];
-		*model = {};
-		model->vertex_count = model_vertex_count;
-		model->vertices = (float32*)linear_allocator_alloc(allocator, sizeof(float32) * 3 * model_vertex_count);
-		model->triangle_count = model_triangle_count;
-		model->triangles = (uint32*)linear_allocator_alloc(allocator, sizeof(uint32) * 3 * model_triangle_count);
-
-		geo_unpack_delta_compressed_floats(
-			file, 
-			deflated_vertex_data_size, 
-			inflated_vertex_data_size, 
-			file_start_of_packed_data_pos + vertex_data_offset,
-			model->vertices,
-			model_vertex_count, 
-			/*components_per_item*/3, 
-			temp_allocator);
+		items += item_size;
+		dst += vertex_stride;
+	}
+}
 
-		geo_unpack_delta_compressed_triangles(
-			file, 
-			deflated_triangle_data_size, 
-			inflated_triangle_data_size, 
-			file_start_of_packed_data_pos + triangle_data_offset, 
-			model->triangles,
-			model_triangle_count, 
-			temp_allocator);
+// vertices, normals or texcoords, returns false if they're corrupt. Streams are decoded straight into the model unless 
+// it's interleaved, then they're decoded into temp memory first
+static bool32 geo_decode_float_stream(Model* model, uint8* delta_compressed_data, uint32 delta_compressed_data_size, float32* dst, uint32 components_per_item, Linear_Allocator* temp_allocator)
+{
+	if (!delta_compressed_data)
+	{
+		return true;
+	}
+
+	if (!model->vertex_stride)
+	{
+		return geo_unpack_delta_compressed_floats(delta_compressed_data, delta_compressed_data_size, dst, model->vertex_count, components_per_item);
+	}
+
+	Linear_Allocator decode_allocator = *temp_allocator;
+	float32* items = (float32*)geo_try_alloc(&decode_allocator, sizeof(float32) * components_per_item * (uint64)model->vertex_count);
+	if (!items || 
+		!geo_unpack_delta_compressed_floats(delta_compressed_data, delta_compressed_data_size, items, model->vertex_count, components_per_item))
+	{
+		return false;
+	}
+
+	geo_interleave_stream((uint8*)items, sizeof(float32) * components_per_item, model->vertex_count, (uint8*)dst, model->vertex_stride);
+	return true;
+}
+
+// bone weights and ids aren't delta compressed, they're just bytes, returns false if there aren't enough
+static bool32 geo_decode_byte_stream(Model* model, uint8* bytes, uint32 byte_count, uint8* dst, uint32 bytes_per_vertex)
+{
+	if (!bytes)
+	{
+		return true;
+	}
+
+	uint64 stream_size = bytes_per_vertex * (uint64)model->vertex_count;
+	if (stream_size > byte_count)
+	{
+		return false;
+	}
+
+	if (!model->vertex_stride)
+	{
+		bytes_copy(dst, bytes, (uint32)stream_size);
+	}
+	else
+	{
+		geo_interleave_stream(bytes, bytes_per_vertex, model->vertex_count, dst, model->vertex_stride);
 	}
+
+	return true;
+}
+
+// inflates and decodes one model's packed data once it's been read, returns false if it's corrupt. Streams 
+// which weren't asked for have empty packed data, so are skipped
+static bool32 geo_decode_model(
+	Model* model, 
+	Geo_Packed_Data* packed_data, // c_geo_stream_count
+	File_Read_Request* read_requests, // c_geo_stream_count
+	Zlib_Inflate_Context* inflate_context, 
+	Linear_Allocator* temp_allocator)
+{
+	uint8* stream_bytes[c_geo_stream_count];
+	for (uint32 i = 0; i < c_geo_stream_count; ++i)
+	{
+		stream_bytes[i] = nullptr;
+
+		if (packed_data[i].inflated_size)
+		{
+			stream_bytes[i] = geo_inflate_packed_data(&packed_data[i], &read_requests[i], inflate_context, temp_allocator);
+			if (!stream_bytes[i])
+			{
+				return false;
+			}
+		}
+	}
+
+	return 
+		geo_unpack_delta_compressed_triangles(
+			stream_bytes[c_geo_stream_triangles], 
+			packed_data[c_geo_stream_triangles].inflated_size, 
+			model->triangles,
+			model->triangle_count, 
+			model->vertex_count) && 
+		geo_decode_float_stream(model, stream_bytes[c_geo_stream_vertices], packed_data[c_geo_stream_vertices].inflated_size, model->vertices, /*components_per_item*/ 3, temp_allocator) && 
+		geo_decode_float_stream(model, stream_bytes[c_geo_stream_normals], packed_data[c_geo_stream_normals].inflated_size, model->normals, /*components_per_item*/ 3, temp_allocator) && 
+		geo_decode_float_stream(model, stream_bytes[c_geo_stream_texcoords], packed_data[c_geo_stream_texcoords].inflated_size, model->texcoords, /*components_per_item*/ 2, temp_allocator) && 
+		geo_decode_byte_stream(model, stream_bytes[c_geo_stream_bone_weights], packed_data[c_geo_stream_bone_weights].inflated_size, model->bone_weights, /*bytes_per_vertex*/ 1) && 
+		geo_decode_byte_stream(model, stream_bytes[c_geo_stream_bone_ids], packed_data[c_geo_stream_bone_ids].inflated_size, model->bone_ids, /*bytes_per_vertex*/ 2);
+}
+
+// temp memory each worker needs for one model, i.e. for its deflated streams, plus somewhere to decode 
+// streams before they're interleaved
+static uint64 geo_model_decode_temp_size(Model* model, Geo_Packed_Data* packed_data)
+{
+	uint64 size = 0;
+	for (uint32 i = 0; i < c_geo_stream_count; ++i)
+	{
+		if (packed_data[i].deflated_size)
+		{
+			size += packed_data[i].inflated_size;
+		}
+	}
+
+	if (model->vertex_stride)
+	{
+		size += sizeof(float32) * 3 * (uint64)model->vertex_count;
+	}
+
+	return size;
+}
+
+// returns false if there isn't room in temp_allocator, the decode then just happens on the calling thread. Each 
+// worker uses the caller's inflate context of the same index
+static bool32 geo_decode_workers_create(Geo_Decode_State* decode_state, int32 worker_count, Zlib_Inflate_Context* inflate_contexts, Linear_Allocator* temp_allocator)
+{
+	uint64 worker_temp_size = 1;
+	for (int32 i = 0; i < decode_state->model_count; ++i)
+	{
+		uint64 model_temp_size = geo_model_decode_temp_size(&decode_state->models[i], &decode_state->packed_data[i * c_geo_stream_count]);
+		worker_temp_size = model_temp_size > worker_temp_size ? model_temp_size : worker_temp_size;
+	}
+
+	if ((sizeof(Geo_Decode_Worker) + worker_temp_size) * worker_count > temp_allocator->bytes_available)
+	{
+		return false;
+	}
+
+	decode_state->workers = (Geo_Decode_Worker*)linear_allocator_alloc(temp_allocator, sizeof(Geo_Decode_Worker) * worker_count);
+	for (int32 i = 0; i < worker_count; ++i)
+	{
+		Geo_Decode_Worker* worker = &decode_state->workers[i];
+		*worker = {};
+
+		linear_allocator_create_sub_allocator(temp_allocator, &worker->temp_allocator, (uint32)worker_temp_size);
+		worker->inflate_context = &inflate_contexts[i];
+	}
+
+	return true;
+}
+
+static void geo_decode_model_job(uint32 item_index, int32 worker_index, void* state)
+{
+	Geo_Decode_State* decode_state = (Geo_Decode_State*)state;
+	Geo_Decode_Worker* worker = &decode_state->workers[worker_index];
+
+	// the reads were all submitted in model order, so these are likely done already, if not then waiting on 
+	// them does reads from the queue until they are
+	File_Read_Request* read_requests = &decode_state->read_requests[item_index * c_geo_stream_count];
+	file_read_wait(decode_state->read_queue, read_requests, c_geo_stream_count);
+
+	linear_allocator_reset(&worker->temp_allocator);
+
+	if (!geo_decode_model(
+		&decode_state->models[item_index], 
+		&decode_state->packed_data[item_index * c_geo_stream_count], 
+		read_requests, 
+		worker->inflate_context, 
+		&worker->temp_allocator))
+	{
+		atomic_increment(&decode_state->corrupt_count);
+	}
+}
+
+// reads everything up to the end of the compressed header, then parses it from memory. A geo already in memory is 
+// parsed where it is. The header points into allocator, see geo_file_read for keeping it between reads of one geo
+bool32 geo_source_header_read(Geo_Header* out_header, const Geo_Source* source, Zlib_Inflate_Context* inflate_context, Linear_Allocator* allocator)
+{
+	if (source->size < 8)
+	{
+		return false;
+	}
+
+	if (!source->file)
+	{
+		uint32 header_size = *(uint32*)source->bytes;
+		if ((uint64)header_size + 4 > source->size)
+		{
+			return false;
+		}
+
+		return geo_header_read(out_header, source->bytes, header_size + 4, inflate_context, allocator);
+	}
+
+	// positional reads, so it doesn't matter where the file is (e.g. if its header has been read before)
+	uint32 header_size;
+	file_read_at(source->file, /*position*/ 0, sizeof(header_size), &header_size);
+	uint8* file_header_bytes = (uint64)header_size + 4 <= source->size ? geo_try_alloc(allocator, (uint64)header_size + 4) : nullptr;
+	if (!file_header_bytes)
+	{
+		return false;
+	}
+
+	*(uint32*)file_header_bytes = header_size;
+	file_read_at(source->file, /*position*/ 4, header_size, &file_header_bytes[4]);
+
+	return geo_header_read(out_header, file_header_bytes, header_size + 4, inflate_context, allocator);
+}
+
+// the counts and packed data (c_geo_stream_count) of one model
+static void geo_header_model_read(Geo_Header* header, int32 model_index, uint32* out_vertex_count, uint32* out_triangle_count, Geo_Packed_Data* out_packed_data)
+{
+	assert(model_index >= 0 && model_index < header->model_count);
+
+	uint8* model_header = header->models_section + (model_index * header->bytes_per_model_header);
+
+	uint32 packed_data_offset = 0; // the streams are back to back starting with triangles
+	switch (header->version)
+	{
+	case 0:
+	case 2:
+		*out_vertex_count = *(uint32*)&model_header[28];
+		*out_triangle_count = *(uint32*)&model_header[32];
+		packed_data_offset = 132;
+		break;
+
+	case 3:
+	case 4:
+	case 5:
+	case 7:
+		*out_vertex_count = *(uint32*)&model_header[16];
+		*out_triangle_count = *(uint32*)&model_header[20];
+		packed_data_offset = 104;
+		break;
+
+	case 8:
+		*out_vertex_count = *(uint32*)&model_header[16];
+		*out_triangle_count = *(uint32*)&model_header[20];
+		packed_data_offset = 108;
+		break;
+
+	default:
+		assert(false);
+		break;
+	}
+
+	bytes_copy((uint8*)out_packed_data, &model_header[packed_data_offset], sizeof(Geo_Packed_Data) * c_geo_stream_count);
+}
+
+static void geo_models_clear(Model* models, int32 model_count)
+{
+	for (int32 i = 0; i < model_count; ++i)
+	{
+		models[i] = {};
+	}
+}
+
+// returns false if the file is corrupt or doesn't have all of model_names in it, in which case every model is left 
+// empty. Nothing read from the file is trusted, so a bad geo can be skipped without taking down the rest of a load. 
+// flags (c_geo_read_*) asks for streams other than vertices and triangles, which are decoded in the same pass. 
+// lod_distances is optional, it's the distance each model will be seen from, which picks the lod to load (see 
+// geo_lod_select). For streaming, load with c_geo_lod_distance_coarsest first, then again with the real distances 
+// into other models once they're needed. read_queue and thread_pool are optional. inflate_contexts has one context 
+// per thread_pool worker (just one without a pool), the first is also used on the calling thread. They're made 
+// once by the caller and reused for every geo, rather than zlib setting itself up again each time. A source in 
+// memory has to stay valid until this returns, since stored streams are decoded straight out of it. header is 
+// optional, it's the source's header from geo_source_header_read, so a second (finer) pass over the same geo doesn't 
+// read and inflate the header again. It has to have been read into an allocator which is still valid
+bool32 geo_file_read(
+	const Geo_Source* source, 
+	const Geo_Header* header, 
+	const char** model_names, 
+	Model* out_models, 
+	int32 model_count, 
+	uint32 flags, 
+	const float32* lod_distances, 
+	File_Read_Queue* read_queue,
+	Thread_Pool* thread_pool, 
+	Zlib_Inflate_Context* inflate_contexts,
+	Linear_Allocator* allocator, 
+	Linear_Allocator* temp_allocator)
+{
+	geo_models_clear(out_models, model_count);
+
+	Zlib_Inflate_Context* inflate_context = &inflate_contexts[0];
+
+	if (!model_count)
+	{
+		return true;
+	}
+
+	// index in the geo of each lod of each requested model
+	int32* lod_model_indices = (int32*)linear_allocator_alloc(temp_allocator, sizeof(int32) * c_geo_max_lods * model_count);
+	for (int32 i = 0; i < model_count * c_geo_max_lods; ++i)
+	{
+		lod_model_indices[i] = -1;
+	}
+
+	Geo_Header geo_header;
+	if (header)
+	{
+		geo_header = *header;
+	}
+	else if (!geo_source_header_read(&geo_header, source, inflate_context, temp_allocator))
+	{
+		return false;
+	}
+
+	// requested name -> its lods in lod_model_indices, so each model in the geo is one lookup
+	Map model_name_map;
+	map_create(&model_name_map, model_count, temp_allocator);
+	for (int32 i = 0; i < model_count; ++i)
+	{
+		map_add(&model_name_map, model_names[i], &lod_model_indices[i * c_geo_max_lods]);
+	}
+
+	for (int32 model_i = 0; model_i < geo_header.model_count; ++model_i)
+	{
+		const char* model_name = geo_header_model_name(&geo_header, model_i);
+		if (!model_name)
+		{
+			return false;
+		}
+
+		// model name often has trick appended e.g. model_name__trick_name, that part isn't in the requested names
+		int32 model_name_length = string_find_last(model_name, "__");
+		if (model_name_length < 0)
+		{
+			model_name_length = string_length(model_name);
+		}
+
+		// a requested name always matches exactly, so asking for e.g. model_name_LOD1 still works
+		int32* model_lod_indices = (int32*)map_find(&model_name_map, model_name, model_name_length);
+		if (model_lod_indices)
+		{
+			model_lod_indices[0] = model_i;
+		}
+
+		// only when a lod is being picked is model_name_LOD<n> also lod n of model_name
+		if (lod_distances)
+		{
+			int32 base_name_length;
+			int32 lod = geo_model_name_lod(model_name, model_name_length, &base_name_length);
+
+			model_lod_indices = lod ? (int32*)map_find(&model_name_map, model_name, base_name_length) : nullptr;
+			if (model_lod_indices)
+			{
+				model_lod_indices[lod] = model_i;
+			}
+		}
+	}
+
+	// pick which lod of each model to load, without lod_distances (or lod info in the geo) it's full detail. If the 
+	// chosen lod isn't in the geo then the next finest one which is gets loaded instead
+	int32* model_indices = (int32*)linear_allocator_alloc(temp_allocator, sizeof(int32) * model_count);
+	for (int32 i = 0; i < model_count; ++i)
+	{
+		int32* model_lod_indices = &lod_model_indices[i * c_geo_max_lods];
+		int32 lod = 0;
+		if (lod_distances && geo_header.model_lods && model_lod_indices[0] >= 0)
+		{
+			lod = geo_lod_select(&geo_header.model_lods[model_lod_indices[0]], lod_distances[i]);
+			while (lod > 0 && model_lod_indices[lod] < 0)
+			{
+				--lod;
+			}
+		}
+
+		model_indices[i] = model_lod_indices[lod];
+		out_models[i].lod = (uint32)lod;
+	}
+
+	// work out where all the packed data is first, so the reads for every model can be in flight at once
+	uint32 stream_count = model_count * c_geo_stream_count;
+	Geo_Packed_Data* packed_data = (Geo_Packed_Data*)linear_allocator_alloc(temp_allocator, sizeof(Geo_Packed_Data) * stream_count);
+	File_Read_Request* read_requests = (File_Read_Request*)linear_allocator_alloc(temp_allocator, sizeof(File_Read_Request) * stream_count);
+
+	// which streams to read, vertices and triangles always are
+	bool32 is_stream_wanted[c_geo_stream_count] = {};
+	is_stream_wanted[c_geo_stream_triangles] = true;
+	is_stream_wanted[c_geo_stream_vertices] = true;
+	is_stream_wanted[c_geo_stream_normals] = (flags & c_geo_read_normals) != 0;
+	is_stream_wanted[c_geo_stream_texcoords] = (flags & c_geo_read_texcoords) != 0;
+	is_stream_wanted[c_geo_stream_bone_weights] = (flags & c_geo_read_bone_weights) != 0;
+	is_stream_wanted[c_geo_stream_bone_ids] = (flags & c_geo_read_bone_ids) != 0;
+
+	// bytes per vertex of each stream, when interleaved the floats go first so they stay aligned
+	static const uint32 c_stream_vertex_sizes[c_geo_stream_count] = { 0, 12, 12, 8, 1, 2 };
+	uint32 stream_vertex_offsets[c_geo_stream_count] = {};
+	uint32 vertex_stride = 0;
+	if (flags & c_geo_read_interleaved)
+	{
+		for (uint32 stream_i = c_geo_stream_vertices; stream_i < c_geo_stream_count; ++stream_i)
+		{
+			if (is_stream_wanted[stream_i])
+			{
+				stream_vertex_offsets[stream_i] = vertex_stride;
+				vertex_stride += c_stream_vertex_sizes[stream_i];
+			}
+		}
+
+		vertex_stride = (vertex_stride + 3) & ~3u;
+	}
+
+	for (int32 i = 0; i < model_count; ++i)
+	{
+		if (model_indices[i] < 0)
+		{
+			geo_models_clear(out_models, model_count);
+			return false;
+		}
+
+		uint32 model_vertex_count;
+		uint32 model_triangle_count;
+		Geo_Packed_Data* model_packed_data = &packed_data[i * c_geo_stream_count];
+		geo_header_model_read(&geo_header, model_indices[i], &model_vertex_count, &model_triangle_count, model_packed_data);
+
+		for (uint32 stream_i = 0; stream_i < c_geo_stream_count; ++stream_i)
+		{
+			if (!is_stream_wanted[stream_i])
+			{
+				model_packed_data[stream_i] = {};
+			}
+		}
+
+		Model* model = &out_models[i];
+		model->vertex_count = model_vertex_count;
+		model->triangle_count = model_triangle_count;
+		model->triangles = (uint32*)geo_try_alloc(allocator, sizeof(uint32) * 3 * (uint64)model_triangle_count);
+		model->vertex_stride = vertex_stride;
+
+		// vertices always get space, other streams only if the model has them
+		uint8* stream_dsts[c_geo_stream_count] = {};
+		if (vertex_stride)
+		{
+			uint8* interleaved_vertices = geo_try_alloc(allocator, vertex_stride * (uint64)model_vertex_count);
+			for (uint32 stream_i = c_geo_stream_vertices; stream_i < c_geo_stream_count; ++stream_i)
+			{
+				if (interleaved_vertices && (stream_i == c_geo_stream_vertices || model_packed_data[stream_i].inflated_size))
+				{
+					stream_dsts[stream_i] = &interleaved_vertices[stream_vertex_offsets[stream_i]];
+				}
+			}
+		}
+		else
+		{
+			for (uint32 stream_i = c_geo_stream_vertices; stream_i < c_geo_stream_count; ++stream_i)
+			{
+				if (stream_i == c_geo_stream_vertices || model_packed_data[stream_i].inflated_size)
+				{
+					// rounded up so the bone streams don't leave the next model's floats unaligned
+					uint64 stream_size = c_stream_vertex_sizes[stream_i] * (uint64)model_vertex_count;
+					stream_dsts[stream_i] = geo_try_alloc(allocator, (stream_size + 3) & ~3ull);
+				}
+			}
+		}
+
+		model->vertices = (float32*)stream_dsts[c_geo_stream_vertices];
+		model->normals = (float32*)stream_dsts[c_geo_stream_normals];
+		model->texcoords = (float32*)stream_dsts[c_geo_stream_texcoords];
+		model->bone_weights = stream_dsts[c_geo_stream_bone_weights];
+		model->bone_ids = stream_dsts[c_geo_stream_bone_ids];
+
+		bool32 is_valid = (!model_triangle_count || model->triangles) && (!model_vertex_count || model->vertices);
+		for (uint32 stream_i = 0; stream_i < c_geo_stream_count && is_valid; ++stream_i)
+		{
+			// a stream with data for a model with no vertices would have nowhere to go
+			is_valid = 
+				(stream_i <= c_geo_stream_vertices || !model_packed_data[stream_i].inflated_size || stream_dsts[stream_i]) && 
+				geo_packed_data_read_request(source, &model_packed_data[stream_i], geo_header.packed_data_offset, &read_requests[(i * c_geo_stream_count) + stream_i], temp_allocator);
+		}
+
+		if (!is_valid)
+		{
+			geo_models_clear(out_models, model_count);
+			return false;
+		}
+	}
+
+	// a geo in memory has nothing to read, its requests are already complete
+	if (source->file)
+	{
+		// without a queue the reads happen one at a time, so at least let the OS start on all of them
+		if (!read_queue)
+		{
+			for (uint32 i = 0; i < stream_count; ++i)
+			{
+				if (read_requests[i].byte_count)
+				{
+					file_prefetch(source->file, read_requests[i].position, read_requests[i].byte_count);
+				}
+			}
+		}
+
+		file_read_submit(read_queue, read_requests, stream_count);
+	}
+
+	bool32 is_corrupt = false;
+
+	Geo_Decode_State decode_state = {};
+	decode_state.models = out_models;
+	decode_state.model_count = model_count;
+	decode_state.packed_data = packed_data;
+	decode_state.read_requests = read_requests;
+	decode_state.read_queue = read_queue;
+
+	// models are independent, so with a pool they're each decoded as soon as their reads are done by whichever worker is free
+	if (thread_pool && model_count > 1 && geo_decode_workers_create(&decode_state, thread_pool->worker_count, inflate_contexts, temp_allocator))
+	{
+		thread_pool_run(thread_pool, model_count, geo_decode_model_job, &decode_state);
+
+		is_corrupt = decode_state.corrupt_count > 0;
+	}
+	else
+	{
+		// decode in order as the reads come in, while later reads are still in flight
+		for (int32 i = 0; i < model_count; ++i)
+		{
+			File_Read_Request* model_read_requests = &read_requests[i * c_geo_stream_count];
+			file_read_wait(read_queue, model_read_requests, c_geo_stream_count);
+
+			if (!geo_decode_model(&out_models[i], &packed_data[i * c_geo_stream_count], model_read_requests, inflate_context, temp_allocator))
+			{
+				// the rest of the reads are into temp memory, so they have to finish before the caller can reuse it
+				uint32 next_request_index = (i + 1) * c_geo_stream_count;
+				file_read_wait(read_queue, &read_requests[next_request_index], stream_count - next_request_index);
+
+				is_corrupt = true;
+				break;
+			}
+		}
+	}
+
+	if (is_corrupt)
+	{
+		geo_models_clear(out_models, model_count);
+		return false;
+	}
+
+	return true;
+}
+
+// the inflated size of a geo header from the size fields at the start of it (see geo_header_read), 0 if they aren't there
+static uint32 geo_header_inflated_size(const uint8* bytes, uint32 byte_count)
+{
+	Buffer_Reader reader;
+	buffer_reader_create(&reader, bytes, byte_count);
+	buffer_reader_skip(&reader, 4); // header size
+
+	// version 0 has the inflated size here, later versions have a 0 then the version
+	uint32 field_2 = buffer_reader_read_u32(&reader);
+	if (field_2)
+	{
+		return field_2;
+	}
+
+	buffer_reader_skip(&reader, 4);
+	return buffer_reader_read_u32(&reader);
+}
+
+// geo_catalog_read, from the start of the geo up to at least the end of its compressed header (as for 
+// geo_header_read) e.g. the copy of it in a pigg's header table (see pigg_read_header). geo_file_size is the size of 
+// the whole geo, which the packed data is checked against
+Geo_Catalog_Result geo_catalog_read_header(
+	Geo_Catalog* out_catalog, 
+	const uint8* header_bytes, 
+	uint32 header_byte_count, 
+	uint64 geo_file_size, 
+	Zlib_Inflate_Context* inflate_context, 
+	Linear_Allocator* allocator, 
+	Linear_Allocator* temp_allocator)
+{
+	*out_catalog = {};
+
+	Linear_Allocator temp = *temp_allocator;
+
+	if (header_byte_count < 8)
+	{
+		return Geo_Catalog_Result::Corrupt;
+	}
+
+	// the deflated header is a little smaller than header_size, which is near enough to tell a size which is 
+	// just too big for temp from one which is corrupt
+	uint32 header_size = *(uint32*)header_bytes;
+	uint32 inflated_header_size = geo_header_inflated_size(header_bytes, header_byte_count);
+	if (inflated_header_size > temp.bytes_available && geo_is_inflated_size_plausible(header_size, inflated_header_size))
+	{
+		return Geo_Catalog_Result::Out_Of_Memory;
+	}
+
+	Geo_Header geo_header;
+	if (!geo_header_read(&geo_header, header_bytes, header_byte_count, inflate_context, &temp))
+	{
+		return Geo_Catalog_Result::Corrupt;
+	}
+
+	// check every model before taking anything from allocator, so how much the catalog needs is known up front
+	uint64 catalog_size = sizeof(Geo_Catalog_Model) * (uint64)geo_header.model_count;
+	for (int32 i = 0; i < geo_header.model_count; ++i)
+	{
+		const char* model_name = geo_header_model_name(&geo_header, i);
+		if (!model_name)
+		{
+			return Geo_Catalog_Result::Corrupt;
+		}
+
+		catalog_size += string_length(model_name) + 1;
+
+		uint32 vertex_count;
+		uint32 triangle_count;
+		Geo_Packed_Data packed_data[c_geo_stream_count];
+		geo_header_model_read(&geo_header, i, &vertex_count, &triangle_count, packed_data);
+
+		for (uint32 stream_i = 0; stream_i < c_geo_stream_count; ++stream_i)
+		{
+			uint32 size_in_file = packed_data[stream_i].deflated_size ? packed_data[stream_i].deflated_size : packed_data[stream_i].inflated_size;
+			if ((uint64)geo_header.packed_data_offset + packed_data[stream_i].offset + size_in_file > geo_file_size || 
+				(packed_data[stream_i].deflated_size && !geo_is_inflated_size_plausible(packed_data[stream_i].deflated_size, packed_data[stream_i].inflated_size)))
+			{
+				return Geo_Catalog_Result::Corrupt;
+			}
+		}
+	}
+
+	if (catalog_size > allocator->bytes_available)
+	{
+		return Geo_Catalog_Result::Out_Of_Memory;
+	}
+
+	Geo_Catalog_Model* models = nullptr;
+	if (geo_header.model_count)
+	{
+		models = (Geo_Catalog_Model*)linear_allocator_alloc(allocator, (uint32)(sizeof(Geo_Catalog_Model) * geo_header.model_count));
+	}
+
+	for (int32 i = 0; i < geo_header.model_count; ++i)
+	{
+		Geo_Catalog_Model* model = &models[i];
+		*model = {};
+		model->name = string_copy(geo_header_model_name(&geo_header, i), allocator);
+
+		uint8* model_header = geo_header.models_section + (i * geo_header.bytes_per_model_header);
+		model->radius = *(float32*)&model_header[4];
+
+		geo_header_model_read(&geo_header, i, &model->vertex_count, &model->triangle_count, model->packed_data);
+	}
+
+	out_catalog->version = geo_header.version;
+	out_catalog->file_size = geo_file_size;
+	out_catalog->packed_data_offset = geo_header.packed_data_offset;
+	out_catalog->models = models;
+	out_catalog->model_count = geo_header.model_count;
+
+	return Geo_Catalog_Result::Ok;
+}
+
+// lists the models in a geo, with their counts and where their packed data is, without reading or inflating any 
+// of it. Returns Corrupt if the geo fails the same checks geo_file_read makes before reading anything, or 
+// Out_Of_Memory if there isn't room to read the header in temp_allocator or for the catalog in allocator, in 
+// which case nothing is left in allocator
+Geo_Catalog_Result geo_catalog_read(Geo_Catalog* out_catalog, File_Handle file, Zlib_Inflate_Context* inflate_context, Linear_Allocator* allocator, Linear_Allocator* temp_allocator)
+{
+	*out_catalog = {};
+
+	Linear_Allocator temp = *temp_allocator;
+
+	uint64 geo_file_size = file_size(file);
+	if (geo_file_size < 8)
+	{
+		return Geo_Catalog_Result::Corrupt;
+	}
+
+	// the header is read and then inflated into temp, so check there's room for both before doing either
+	uint32 header_size = file_read_u32(file);
+	if ((uint64)header_size + 4 > geo_file_size)
+	{
+		return Geo_Catalog_Result::Corrupt;
+	}
+
+	uint8* file_header_bytes = geo_try_alloc(&temp, (uint64)header_size + 4);
+	if (!file_header_bytes)
+	{
+		return Geo_Catalog_Result::Out_Of_Memory;
+	}
+
+	*(uint32*)file_header_bytes = header_size;
+	file_read(file, header_size, &file_header_bytes[4]);
+
+	return geo_catalog_read_header(out_catalog, file_header_bytes, header_size + 4, geo_file_size, inflate_context, allocator, &temp);
+}
+
+// bytes geo_catalog_dir needs to copy a catalog's path and models into its allocator
+static uint64 geo_catalog_copy_size(Geo_Catalog* catalog)
+{
+	uint64 size = string_length(catalog->path) + 1 + (sizeof(Geo_Catalog_Model) * (uint64)catalog->model_count);
+	for (int32 i = 0; i < catalog->model_count; ++i)
+	{
+		size += string_length(catalog->models[i].name) + 1;
+	}
+
+	return size;
+}
+
+static void geo_catalog_file(uint32 item_index, int32 worker_index, void* state)
+{
+	Geo_Catalog_State* catalog_state = (Geo_Catalog_State*)state;
+	Geo_Catalog_Worker* worker = &catalog_state->workers[worker_index];
+
+	linear_allocator_reset(&worker->temp_allocator);
+
+	const char* path = file_search_result_path(catalog_state->search_results, item_index);
+	File_Handle file = file_open_read(path);
+	if (!file_is_valid(file))
+	{
+		catalog_state->catalog_results[item_index] = Geo_Catalog_Result::Corrupt;
+		return;
+	}
+
+	Geo_Catalog* catalog = &catalog_state->catalogs[item_index];
+	catalog_state->catalog_results[item_index] = geo_catalog_read(catalog, file, &worker->inflate_context, &worker->allocator, &worker->temp_allocator);
+	catalog->path = path;
+
+	file_close(file);
+}
+
+// catalogs every .geo under dir_path (see geo_catalog_read), spread across thread_pool (optional). Returns how many 
+// catalogs are in out_catalogs, geos which couldn't be opened or are corrupt are left out and counted in out_failed_count. 
+// Everything is done in temp_allocator, which is split between the workers, then the catalogs are copied into allocator. 
+// If that runs out, so some geos weren't found or were left out for lack of room, out_is_out_of_memory is set
+uint32 geo_catalog_dir(
+	Geo_Catalog** out_catalogs, 
+	const char* dir_path, 
+	Thread_Pool* thread_pool, 
+	Linear_Allocator* allocator, 
+	Linear_Allocator* temp_allocator, 
+	uint32* out_failed_count, 
+	bool32* out_is_out_of_memory)
+{
+	*out_catalogs = nullptr;
+	*out_failed_count = 0;
+	*out_is_out_of_memory = false;
+
+	Linear_Allocator temp = *temp_allocator;
+
+	// the search works in the back half of temp memory, and the results go at the front
+	File_Search_Results search_results;
+	{
+		Linear_Allocator search_temp_allocator = temp;
+		linear_allocator_alloc(&search_temp_allocator, search_temp_allocator.bytes_available / 2);
+		file_search_parallel(&search_results, dir_path, "*.geo", /*include_subdirs*/ true, thread_pool, &temp, &search_temp_allocator);
+	}
+
+	int32 worker_count = thread_pool ? thread_pool->worker_count : 1;
+
+	// each worker needs an inflate context, then gets an equal share of what's left, half for its catalogs and half 
+	// for reading headers. Give up straight away if that's not even enough for a small geo
+	uint64 state_size = (sizeof(Geo_Catalog) + sizeof(Geo_Catalog_Result)) * (uint64)u32_max(search_results.path_count, 1) + 
+		(sizeof(Geo_Catalog_Worker) + zlib_inflate_context_size()) * (uint64)worker_count;
+	if (state_size >= temp.bytes_available || 
+		(temp.bytes_available - state_size) / (worker_count * 2) < c_geo_catalog_min_worker_allocator_size)
+	{
+		*out_is_out_of_memory = true;
+		return 0;
+	}
+
+	Geo_Catalog_State catalog_state = {};
+	catalog_state.search_results = &search_results;
+	catalog_state.catalogs = (Geo_Catalog*)linear_allocator_alloc(&temp, sizeof(Geo_Catalog) * u32_max(search_results.path_count, 1));
+	catalog_state.catalog_results = (Geo_Catalog_Result*)linear_allocator_alloc(&temp, sizeof(Geo_Catalog_Result) * u32_max(search_results.path_count, 1));
+	catalog_state.workers = (Geo_Catalog_Worker*)linear_allocator_alloc(&temp, sizeof(Geo_Catalog_Worker) * worker_count);
+
+	for (int32 i = 0; i < worker_count; ++i)
+	{
+		zlib_inflate_context_create(&catalog_state.workers[i].inflate_context, &temp);
+	}
+
+	uint32 worker_allocator_size = temp.bytes_available / (worker_count * 2);
+	for (int32 i = 0; i < worker_count; ++i)
+	{
+		Geo_Catalog_Worker* worker = &catalog_state.workers[i];
+		linear_allocator_create_sub_allocator(&temp, &worker->allocator, worker_allocator_size);
+		linear_allocator_create_sub_allocator(&temp, &worker->temp_allocator, worker_allocator_size);
+	}
+
+	if (thread_pool)
+	{
+		thread_pool_run(thread_pool, search_results.path_count, geo_catalog_file, &catalog_state);
+	}
+	else
+	{
+		for (uint32 i = 0; i < search_results.path_count; ++i)
+		{
+			geo_catalog_file(i, /*worker_index*/ 0, &catalog_state);
+		}
+	}
+
+	uint32 catalog_count = 0;
+	uint32 failed_count = 0;
+	bool32 is_out_of_memory = search_results.is_truncated;
+	for (uint32 i = 0; i < search_results.path_count; ++i)
+	{
+		switch (catalog_state.catalog_results[i])
+		{
+		case Geo_Catalog_Result::Ok:
+			++catalog_count;
+			break;
+
+		case Geo_Catalog_Result::Corrupt:
+			++failed_count;
+			break;
+
+		case Geo_Catalog_Result::Out_Of_Memory:
+			is_out_of_memory = true;
+			break;
+		}
+	}
+
+	// gather the catalogs up in search order, checking each one fits before copying it, the ones which don't are 
+	// left out like any other geo there wasn't room for
+	uint64 catalogs_size = sizeof(Geo_Catalog) * (uint64)u32_max(catalog_count, 1);
+	if (catalogs_size > allocator->bytes_available)
+	{
+		*out_failed_count = failed_count;
+		*out_is_out_of_memory = true;
+		return 0;
+	}
+
+	Geo_Catalog* catalogs = (Geo_Catalog*)linear_allocator_alloc(allocator, (uint32)catalogs_size);
+	Geo_Catalog* catalog_iter = catalogs;
+	for (uint32 i = 0; i < search_results.path_count; ++i)
+	{
+		if (catalog_state.catalog_results[i] != Geo_Catalog_Result::Ok)
+		{
+			continue;
+		}
+
+		Geo_Catalog* src = &catalog_state.catalogs[i];
+		if (geo_catalog_copy_size(src) > allocator->bytes_available)
+		{
+			is_out_of_memory = true;
+			continue;
+		}
+
+		Geo_Catalog* dst = catalog_iter++;
+		*dst = *src;
+		dst->path = string_copy(src->path, allocator);
+		dst->models = nullptr;
+
+		if (src->model_count)
+		{
+			dst->models = (Geo_Catalog_Model*)linear_allocator_alloc(allocator, sizeof(Geo_Catalog_Model) * src->model_count);
+			for (int32 model_i = 0; model_i < src->model_count; ++model_i)
+			{
+				dst->models[model_i] = src->models[model_i];
+				dst->models[model_i].name = string_copy(src->models[model_i].name, allocator);
+			}
+		}
+	}
+
+	*out_catalogs = catalogs;
+	*out_failed_count = failed_count;
+	*out_is_out_of_memory = is_out_of_memory;
+	return (uint32)(catalog_iter - catalogs);
+}
+
+static bool32 geo_is_geo_path(const char* path)
+{
+	int32 extension_index = string_find_last(path, '.');
+	return extension_index >= 0 && string_equals_ignore_case(&path[extension_index], ".geo");
+}
+
+// catalogs every .geo in a pigg (see geo_catalog_read) from the copy of its header in the pigg's header table, so 
+// no entry data is read. A geo without a header row is read (and inflated if need be) whole, the catalog's path is 
+// its entry name so it's only valid until the pigg is closed. Otherwise the same as geo_catalog_dir, the catalogs 
+// go in allocator, and if there isn't room for them all (or a header in temp_allocator) out_is_out_of_memory is set
+uint32 geo_catalog_pigg(
+	Geo_Catalog** out_catalogs, 
+	Pigg_Archive* archive, 
+	Zlib_Inflate_Context* inflate_context, 
+	Linear_Allocator* allocator, 
+	Linear_Allocator* temp_allocator, 
+	uint32* out_failed_count, 
+	bool32* out_is_out_of_memory)
+{
+	*out_catalogs = nullptr;
+	*out_failed_count = 0;
+	*out_is_out_of_memory = false;
+
+	uint32 geo_count = 0;
+	for (uint32 i = 0; i < archive->entry_count; ++i)
+	{
+		if (geo_is_geo_path(pigg_entry_name(archive, &archive->entries[i])))
+		{
+			++geo_count;
+		}
+	}
+
+	uint64 catalogs_size = sizeof(Geo_Catalog) * (uint64)u32_max(geo_count, 1);
+	if (catalogs_size > allocator->bytes_available)
+	{
+		*out_is_out_of_memory = true;
+		return 0;
+	}
+
+	Geo_Catalog* catalogs = (Geo_Catalog*)linear_allocator_alloc(allocator, (uint32)catalogs_size);
+	uint32 catalog_count = 0;
+	uint32 failed_count = 0;
+	bool32 is_out_of_memory = false;
+	for (uint32 i = 0; i < archive->entry_count; ++i)
+	{
+		Pigg_Entry* entry = &archive->entries[i];
+		const char* path = pigg_entry_name(archive, entry);
+		if (!geo_is_geo_path(path))
+		{
+			continue;
+		}
+
+		// reset for each geo
+		Linear_Allocator temp = *temp_allocator;
+
+		uint32 header_byte_count;
+		const uint8* header_bytes = pigg_read_header(archive, entry, &temp, &header_byte_count);
+		if (!header_bytes)
+		{
+			header_bytes = pigg_read_mapped(archive, entry, &temp);
+			header_byte_count = header_bytes ? entry->file_size : 0;
+		}
+
+		// a geo which can't be read at all is only corrupt if it wasn't just too big for temp
+		Geo_Catalog_Result result = entry->file_size > temp.bytes_available ? Geo_Catalog_Result::Out_Of_Memory : Geo_Catalog_Result::Corrupt;
+		if (header_bytes)
+		{
+			result = geo_catalog_read_header(&catalogs[catalog_count], header_bytes, header_byte_count, entry->file_size, inflate_context, allocator, &temp);
+		}
+
+		switch (result)
+		{
+		case Geo_Catalog_Result::Ok:
+			catalogs[catalog_count].path = path;
+			++catalog_count;
+			break;
+
+		case Geo_Catalog_Result::Corrupt:
+			++failed_count;
+			break;
+
+		case Geo_Catalog_Result::Out_Of_Memory:
+			is_out_of_memory = true;
+			break;
+		}
+	}
+
+	*out_catalogs = catalogs;
+	*out_failed_count = failed_count;
+	*out_is_out_of_memory = is_out_of_memory;
+	return catalog_count;
 }
\ No newline at end of file
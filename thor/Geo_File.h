@@ -4,10 +4,141 @@
 
 
 
-void geo_file_read(
-	File_Handle file, 
+// geo_file_read flags, vertices and triangles are always read
+constexpr uint32 c_geo_read_normals = 1 << 0;
+constexpr uint32 c_geo_read_texcoords = 1 << 1;
+constexpr uint32 c_geo_read_bone_weights = 1 << 2;
+constexpr uint32 c_geo_read_bone_ids = 1 << 3;
+constexpr uint32 c_geo_read_interleaved = 1 << 4; // all of a model's vertex streams in one buffer, see Model
+
+// packed data streams, in the order they are in a model header
+constexpr uint32 c_geo_stream_triangles = 0;
+constexpr uint32 c_geo_stream_vertices = 1;
+constexpr uint32 c_geo_stream_normals = 2;
+constexpr uint32 c_geo_stream_texcoords = 3;
+constexpr uint32 c_geo_stream_bone_weights = 4;
+constexpr uint32 c_geo_stream_bone_ids = 5;
+constexpr uint32 c_geo_stream_count = 6;
+
+constexpr int32 c_geo_max_lods = 6;
+constexpr float32 c_geo_lod_distance_coarsest = 3.4e38f; // for geo_file_read lod_distances, loads the coarsest lod of a model
+
+
+struct Geo_Packed_Data
+{
+	uint32 deflated_size; // 0 if stored uncompressed
+	uint32 inflated_size;
+	uint32 offset; // from the start of the packed data
+};
+
+struct Geo_Lod
+{
+	float32 allowed_error;
+	float32 near_distance; // invisible closer than this (near and far are macros in windows.h)
+	float32 far_distance; // invisible farther than this
+	float32 near_fade;
+	float32 far_fade;
+	uint32 flags;
+};
+
+// lod 0 is the model itself, lod n is assumed to be a model in the same geo with the same name plus "_LOD<n>". That 
+// naming isn't in documentation/geo_file_format.md, the format only has the lod distances
+struct Geo_Model_Lods
+{
+	uint32 used_lod_count;
+	Geo_Lod lods[c_geo_max_lods];
+};
+
+struct Geo_Header
+{
+	uint32 version;
+	uint8* model_names_section;
+	uint32 model_names_section_size;
+	uint8* models_section;
+	int32 model_count;
+	int32 bytes_per_model_header;
+	uint32 packed_data_offset; // offset from start of file
+	Geo_Model_Lods* model_lods; // one per model, null if the geo has none (versions 0, 7 and 8)
+};
+
+// where a geo is read from, either an open file or the whole geo already in memory (e.g. a geo mapped out of a 
+// pigg), reads from memory are just pointers into it so nothing is copied
+struct Geo_Source
+{
+	File_Handle file; // null if the geo is in memory
+	const uint8* bytes;
+	uint64 size;
+};
+
+enum class Geo_Catalog_Result
+{
+	Ok,
+	Corrupt,
+	Out_Of_Memory // not corrupt as far as it got, but there wasn't room to finish
+};
+
+// what's in a geo, from just its header (see geo_catalog_read)
+struct Geo_Catalog_Model
+{
+	const char* name; // may have a trick appended e.g. model_name__trick_name
+	float32 radius; // of the bounding sphere, which is the only bounds in the header
+	uint32 vertex_count;
+	uint32 triangle_count;
+	Geo_Packed_Data packed_data[c_geo_stream_count];
+};
+
+struct Geo_Catalog
+{
+	const char* path; // only set by geo_catalog_dir and geo_catalog_pigg
+	uint32 version;
+	uint64 file_size;
+	uint32 packed_data_offset; // offset from start of file
+	Geo_Catalog_Model* models;
+	int32 model_count;
+};
+
+
+void geo_source_create(Geo_Source* out_source, File_Handle file);
+void geo_source_create_from_memory(Geo_Source* out_source, const uint8* bytes, uint64 size);
+bool32 geo_header_read(Geo_Header* out_header, const uint8* bytes, uint32 byte_count, struct Zlib_Inflate_Context* inflate_context, struct Linear_Allocator* allocator);
+bool32 geo_source_header_read(Geo_Header* out_header, const Geo_Source* source, Zlib_Inflate_Context* inflate_context, Linear_Allocator* allocator);
+const char* geo_header_model_name(Geo_Header* header, int32 model_index);
+int32 geo_lod_select(const Geo_Model_Lods* model_lods, float32 distance);
+bool32 geo_file_read(
+	const Geo_Source* source, 
+	const Geo_Header* header, 
 	const char** model_names, 
 	struct Model* out_models, 
 	int32 model_count, 
-	struct Linear_Allocator* allocator, 
-	Linear_Allocator* temp_allocator);
\ No newline at end of file
+	uint32 flags, 
+	const float32* lod_distances, 
+	File_Read_Queue* read_queue, 
+	struct Thread_Pool* thread_pool, 
+	Zlib_Inflate_Context* inflate_contexts, 
+	Linear_Allocator* allocator, 
+	Linear_Allocator* temp_allocator);
+Geo_Catalog_Result geo_catalog_read_header(
+	Geo_Catalog* out_catalog, 
+	const uint8* header_bytes, 
+	uint32 header_byte_count, 
+	uint64 geo_file_size, 
+	Zlib_Inflate_Context* inflate_context, 
+	Linear_Allocator* allocator, 
+	Linear_Allocator* temp_allocator);
+Geo_Catalog_Result geo_catalog_read(Geo_Catalog* out_catalog, File_Handle file, Zlib_Inflate_Context* inflate_context, Linear_Allocator* allocator, Linear_Allocator* temp_allocator);
+uint32 geo_catalog_dir(
+	Geo_Catalog** out_catalogs, 
+	const char* dir_path, 
+	struct Thread_Pool* thread_pool, 
+	Linear_Allocator* allocator, 
+	Linear_Allocator* temp_allocator, 
+	uint32* out_failed_count, 
+	bool32* out_is_out_of_memory);
+uint32 geo_catalog_pigg(
+	Geo_Catalog** out_catalogs, 
+	struct Pigg_Archive* archive, 
+	Zlib_Inflate_Context* inflate_context, 
+	Linear_Allocator* allocator, 
+	Linear_Allocator* temp_allocator, 
+	uint32* out_failed_count, 
+	bool32* out_is_out_of_memory);
\ No newline at end of file
@@ -53,7 +53,7 @@ static uint32 get_memory_type_index(VkPhysicalDeviceMemoryProperties* gpu_memory
 static VkShaderModule create_shader_module(VkDevice device, const char* shader_file_path, Linear_Allocator* temp_allocator)
 {
 	File_Handle shader_file = file_open_read(shader_file_path);
-	uint32 shader_file_size = file_size(shader_file);
+	uint32 shader_file_size = (uint32)file_size(shader_file);
 	uint8* shader_bytes = linear_allocator_alloc(temp_allocator, shader_file_size);
 	file_read(shader_file, shader_file_size, /*out*/ shader_bytes);
 
@@ -511,6 +511,14 @@ void graphics_init(
 	uint32 supported_memory_type_bits = (uint32)-1;
 	for (int32 model_i = 0; model_i < model_count; ++model_i)
 	{
+		// a model with nothing in it gets no buffers and isn't drawn, vulkan doesn't allow empty buffers
+		if (!models[model_i].vertex_count || !models[model_i].triangle_count)
+		{
+			vertex_buffers[model_i] = VK_NULL_HANDLE;
+			index_buffers[model_i] = VK_NULL_HANDLE;
+			continue;
+		}
+
 		vertex_buffers[model_i] = create_buffer(graphics_state->device, models[model_i].vertex_count * c_bytes_per_vertex, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
 		index_buffers[model_i] = create_buffer(graphics_state->device, models[model_i].triangle_count * c_bytes_per_triangle, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
 
@@ -534,6 +542,11 @@ void graphics_init(
 	VkDeviceSize mesh_buffer_memory_offset = 0;
 	for (int32 model_i = 0; model_i < model_count; ++model_i)
 	{
+		if (vertex_buffers[model_i] == VK_NULL_HANDLE)
+		{
+			continue;
+		}
+
 		result = vkBindBufferMemory(graphics_state->device, vertex_buffers[model_i], mesh_buffer_memory, mesh_buffer_memory_offset);
 		assert(result == VK_SUCCESS);
 
@@ -1029,6 +1042,13 @@ void graphics_init(
 			{
 				UBO::Model_Info* model_info = &ubo->models[model_i];
 
+				// empty models still have transforms in the ubo, so the instance index moves past them
+				if (vertex_buffers[model_info->model_index] == VK_NULL_HANDLE)
+				{
+					global_instance_i += model_info->instance_count;
+					continue;
+				}
+
 				VkDeviceSize offset = 0;
 				vkCmdBindVertexBuffers(command_buffer, /*first_binding*/ 0, /*binding_count*/ 1, &vertex_buffers[model_info->model_index], &offset);
 
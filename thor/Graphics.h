@@ -2,7 +2,9 @@
 
 #include "Core.h"
 #include "Maths.h"
+#if _WIN32
 #include <Windows.h>
+#endif
 
 
 
@@ -41,15 +43,26 @@ struct UBO
 	int32 model_count;
 };
 
+// streams other than vertices and triangles are only read if asked for (see geo_file_read), and are null if the model 
+// doesn't have them. If interleaved, every stream points into one buffer (starting at vertices) with vertex_stride 
+// bytes from one vertex to the next, otherwise each stream is tightly packed
 struct Model
 {
 	float32* vertices;
 	uint32 vertex_count;
 	uint32* triangles;
 	uint32 triangle_count;
+	float32* normals; // 3 per vertex
+	float32* texcoords; // 2 per vertex
+	uint8* bone_weights; // 1 per vertex, 255 is all bone_ids[0], 0 is all bone_ids[1]
+	uint8* bone_ids; // 2 per vertex
+	uint32 vertex_stride; // 0 if not interleaved
+	uint32 lod; // 0 is full detail
 };
 
 
+// the renderer is Win32 only, the rest of Graphics.h (e.g. Model) is shared with the loaders on other platforms
+#if _WIN32
 void graphics_init(
 	Graphics_State* graphics_state, 
 	HINSTANCE instance_handle, 
@@ -62,4 +75,5 @@ void graphics_init(
 	Transform** model_instances, 
 	struct Linear_Allocator* allocator, 
 	Linear_Allocator* temp_allocator);
-void graphics_draw(Graphics_State* graphics_state, Matrix_4x4* view_matrix);
\ No newline at end of file
+void graphics_draw(Graphics_State* graphics_state, Matrix_4x4* view_matrix);
+#endif // _WIN32
\ No newline at end of file
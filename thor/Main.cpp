@@ -4,8 +4,12 @@
 #include "Geo_File.h"
 #include "Graphics.h"
 #include "Memory.h"
+#include "Pigg_File.h"
 #include "String.h"
+#include "Thread.h"
+#include "Zlib.h"
 #include <cmath>
+#include <cstdio>
 #include <Windows.h>
 
 
@@ -60,9 +64,184 @@ static LRESULT CALLBACK window_callback(HWND window_handle, UINT msg, WPARAM w_p
 	return 0;
 }
 
+// checks every entry in a pigg against its stored md5, names of bad entries go to the debugger output, 
+// returns the number of bad entries, or -1 if the pigg couldn't be opened or its entries don't fit in memory
+static int32 verify_pigg_file(const char* pigg_file_path)
+{
+	Linear_Allocator allocator;
+	linear_allocator_create(&allocator, megabytes(512));
+
+	char buffer[512];
+
+	Pigg_Archive archive;
+	if (!pigg_open_mapped(&archive, pigg_file_path, &allocator))
+	{
+		snprintf(buffer, sizeof(buffer), "[verify] %s: can't be opened, or its tables are corrupt\n", pigg_file_path);
+		OutputDebugStringA(buffer);
+
+		linear_allocator_destroy(&allocator);
+		return -1;
+	}
+
+	// each worker holds a few of the biggest entries at once, so only use as many as there's room for, pigg_verify 
+	// makes the final call on whether even one fits
+	uint64 max_entry_size = 0;
+	for (uint32 i = 0; i < archive.entry_count; ++i)
+	{
+		uint64 entry_size = (uint64)archive.entries[i].file_size + archive.entries[i].compressed_size;
+		max_entry_size = entry_size > max_entry_size ? entry_size : max_entry_size;
+	}
+	uint64 worker_memory_size = (max_entry_size * 4) + kilobytes(64);
+	int32 worker_count = thread_get_processor_count();
+	uint64 max_worker_count = (allocator.bytes_available / 2) / worker_memory_size;
+	if ((uint64)worker_count > max_worker_count)
+	{
+		worker_count = max_worker_count ? (int32)max_worker_count : 1;
+	}
+
+	Thread_Pool thread_pool;
+	thread_pool_create(&thread_pool, worker_count, &allocator);
+
+	Pigg_Entry** bad_entries;
+	uint32 bad_entry_count;
+	if (!pigg_verify(&archive, &thread_pool, /*read_queue*/ nullptr, &allocator, &bad_entries, &bad_entry_count))
+	{
+		snprintf(buffer, sizeof(buffer), "[verify] %s: entries are too big to verify in memory\n", pigg_file_path);
+		OutputDebugStringA(buffer);
+
+		pigg_close(&archive);
+		thread_pool_destroy(&thread_pool);
+		linear_allocator_destroy(&allocator);
+		return -1;
+	}
+
+	for (uint32 i = 0; i < bad_entry_count; ++i)
+	{
+		snprintf(buffer, sizeof(buffer), "[verify] bad entry %s\n", pigg_entry_name(&archive, bad_entries[i]));
+		OutputDebugStringA(buffer);
+	}
+
+	snprintf(buffer, sizeof(buffer), "[verify] %s: %u of %u entries bad\n", pigg_file_path, bad_entry_count, archive.entry_count);
+	OutputDebugStringA(buffer);
+
+	pigg_close(&archive);
+	thread_pool_destroy(&thread_pool);
+	linear_allocator_destroy(&allocator);
+
+	return (int32)bad_entry_count;
+}
+
+// copies the next space separated argument in args to out_arg, which is left empty if there isn't one (or it doesn't 
+// fit), returns where the rest of the arguments start
+static const char* command_line_next_arg(const char* args, char* out_arg, int32 out_arg_size)
+{
+	while (*args == ' ')
+	{
+		++args;
+	}
+
+	int32 arg_length = string_find(args, ' ');
+	if (arg_length < 0)
+	{
+		arg_length = string_length(args);
+	}
+
+	*out_arg = 0;
+	if (arg_length && arg_length < out_arg_size)
+	{
+		string_copy(out_arg, out_arg_size, args, arg_length);
+	}
+
+	return &args[arg_length];
+}
+
+// packs a directory, or repacks a pigg, into a new pigg with every entry page aligned. Files from a directory are 
+// deflated at the default level, entries from a pigg keep their compression. If a trace (see pigg_pack_trace_read) 
+// is given, the files in it go first in the order they're listed. Returns 0, or -1 if the source couldn't be packed
+static int32 pack_pigg_file(const char* out_file_path, const char* source_path, const char* trace_file_path)
+{
+	Linear_Allocator allocator;
+	linear_allocator_create(&allocator, megabytes(512));
+
+	char buffer[512];
+
+	Pigg_Pack_Options options = {};
+	options.alignment = kilobytes(4);
+	options.deflate_level = c_zlib_deflate_level_default;
+	if (*trace_file_path)
+	{
+		options.trace = pigg_pack_trace_read(trace_file_path, &allocator, &options.trace_count);
+	}
+
+	int32 source_path_length = string_length(source_path);
+	bool32 is_source_pigg = source_path_length > 5 && string_equals_ignore_case(&source_path[source_path_length - 5], ".pigg");
+
+	bool32 is_packed = false;
+	if (is_source_pigg)
+	{
+		Pigg_Archive source;
+		if (pigg_open(&source, source_path, &allocator))
+		{
+			pigg_pack_archive(out_file_path, &source, &options, &allocator);
+			pigg_close(&source);
+			is_packed = true;
+		}
+	}
+	else
+	{
+		// the pool is only used to find the directory's files
+		Thread_Pool thread_pool;
+		thread_pool_create(&thread_pool, thread_get_processor_count(), &allocator);
+
+		is_packed = pigg_pack_dir(out_file_path, source_path, &options, &thread_pool, &allocator);
+
+		thread_pool_destroy(&thread_pool);
+	}
+
+	if (is_packed)
+	{
+		snprintf(buffer, sizeof(buffer), "[pack] %s: packed from %s\n", out_file_path, source_path);
+	}
+	else
+	{
+		snprintf(buffer, sizeof(buffer), "[pack] %s: %s can't be opened, or is too big to pack in memory\n", out_file_path, source_path);
+	}
+	OutputDebugStringA(buffer);
+
+	linear_allocator_destroy(&allocator);
+
+	return is_packed ? 0 : -1;
+}
+
 // todo(jbr) would it be better to use wall and disable selectively?
 int CALLBACK WinMain(HINSTANCE instance_handle, HINSTANCE /*prev_instance_handle*/, LPSTR cmd_line, int /*cmd_show*/)
 {
+	// "verify <pigg path>" checks the pigg instead of starting the viewer, exit code is as verify_pigg_file returns
+	if (string_starts_with(cmd_line, "verify "))
+	{
+		return verify_pigg_file(&cmd_line[7]);
+	}
+
+	// "pack <out pigg path> <dir or pigg path> [<trace path>]" packs a pigg instead of starting the viewer, paths 
+	// can't have spaces in them. Exit code is as pack_pigg_file returns
+	if (string_starts_with(cmd_line, "pack "))
+	{
+		char out_file_path[256];
+		char source_path[256];
+		char trace_file_path[256];
+		const char* args = command_line_next_arg(&cmd_line[5], out_file_path, sizeof(out_file_path));
+		args = command_line_next_arg(args, source_path, sizeof(source_path));
+		command_line_next_arg(args, trace_file_path, sizeof(trace_file_path));
+
+		if (!*out_file_path || !*source_path)
+		{
+			OutputDebugStringA("[pack] usage: pack <out pigg path> <dir or pigg path> [<trace path>]\n");
+			return -1;
+		}
+
+		return pack_pigg_file(out_file_path, source_path, trace_file_path);
+	}
+
 	const char* window_class_name = "Thor_Window_Class";
 
 	WNDCLASSA window_class = {};
@@ -107,7 +286,7 @@ int CALLBACK WinMain(HINSTANCE instance_handle, HINSTANCE /*prev_instance_handle
 	bool32 was_sleep_granularity_set = timeBeginPeriod(1) == TIMERR_NOERROR;
 
 	Linear_Allocator allocator;
-	linear_allocator_create(&allocator, megabytes(128));
+	linear_allocator_create(&allocator, megabytes(192));
 
 	Linear_Allocator permanent_allocator;
 	linear_allocator_create_sub_allocator(&allocator, &permanent_allocator, megabytes(32));
@@ -116,9 +295,6 @@ int CALLBACK WinMain(HINSTANCE instance_handle, HINSTANCE /*prev_instance_handle
 	
 	const char* coh_data_path = cmd_line;
 
-	char geobin_file_path[256];
-	string_concat(geobin_file_path, sizeof(geobin_file_path), coh_data_path, "/geobin/maps/City_Zones/City_01_01/City_01_01.bin");
-		
 	// create two allocators for geobin read
 	// 1 - allocator for the results of loading the geobin
 	// 2 - temp allocator just for the function
@@ -126,26 +302,44 @@ int CALLBACK WinMain(HINSTANCE instance_handle, HINSTANCE /*prev_instance_handle
 	Linear_Allocator geobin_read_allocator;
 	linear_allocator_create_sub_allocator(&allocator, &geobin_read_allocator, megabytes(32));
 
+	// the piggs' entry and name tables, so files are looked up and read straight out of the shipped piggs
+	Linear_Allocator mount_allocator;
+	linear_allocator_create_sub_allocator(&allocator, &mount_allocator, megabytes(64));
+
 	Linear_Allocator temp_allocator;
 	linear_allocator_create_sub_allocator(&allocator, &temp_allocator);
 
+	char piggs_path[256];
+	string_concat(piggs_path, sizeof(piggs_path), coh_data_path, "/piggs");
+
+	// without any piggs, everything is read from the loose files under the data path
+	Pigg_Mount mount;
+	pigg_mount_create(&mount, piggs_path, &mount_allocator, &temp_allocator);
+	linear_allocator_reset(&temp_allocator);
+
 	int32 model_count;
 	Model* models;
 	int32* model_instance_count;
 	Transform** model_instances;
 
-	File_Handle geobin_file = file_open_read(geobin_file_path);
+	// geos are decoded a model per job across every core
+	Thread_Pool thread_pool;
+	thread_pool_create(&thread_pool, thread_get_processor_count(), &temp_allocator);
+
 	geobin_file_read(
-		geobin_file, 
 		"maps/City_Zones/City_01_01/City_01_01.bin", 
 		coh_data_path,
+		mount.archive_count ? &mount : nullptr,
 		&model_count,
 		&models,
 		&model_instance_count,
 		&model_instances,
+		&thread_pool, 
 		&geobin_read_allocator, 
 		&temp_allocator);
-	file_close(geobin_file);
+
+	thread_pool_destroy(&thread_pool);
+	pigg_mount_destroy(&mount);
 
 	// reset and reuse for graphics_init
 	linear_allocator_reset(&temp_allocator);
@@ -166,6 +360,7 @@ int CALLBACK WinMain(HINSTANCE instance_handle, HINSTANCE /*prev_instance_handle
 
 	// now throw away all allocators after permanent allocator
 	linear_allocator_destroy_sub_allocator(&allocator, &temp_allocator);
+	linear_allocator_destroy_sub_allocator(&allocator, &mount_allocator);
 	linear_allocator_destroy_sub_allocator(&allocator, &geobin_read_allocator);
 
 	bool32 was_mouse_down = 0;
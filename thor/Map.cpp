@@ -0,0 +1,189 @@
+#include "Map.h"
+
+#include "Maths.h"
+#include "Memory.h"
+#include "String.h"
+
+
+
+constexpr uint32 c_crc_32_generator = 0x04C11DB7;
+constexpr uint32 c_crc_32_init = 0xffffffff;
+constexpr uint32 c_crc_32_xor_out = 0xffffffff;
+static uint32 crc_32_slow(uint8* input, int32 input_size)
+{
+	uint32 crc = 0;
+
+	uint8* input_end = &input[input_size];
+	for (; input != input_end; ++input)
+	{
+		crc ^= (*input << 24);
+
+		for (int32 j = 0; j < 8; ++j)
+		{
+			if (crc & (1 << 31))
+			{
+				crc = (crc << 1) ^ c_crc_32_generator;
+			}
+			else
+			{
+				crc <<= 1;
+			}
+		}
+	}
+
+	return crc;
+} // todo(jbr) can we do the byte flipping thing by shifting the other direction?
+
+static uint32* crc_32_create_table()
+{
+	static uint32 table[256];
+
+	for (int32 i = 0; i < 256; ++i)
+	{
+		uint8 input = (uint8)i;
+		table[i] = crc_32_slow(&input, 1);
+	}
+
+	return table;
+}
+static uint32* s_crc_32_table = crc_32_create_table();
+
+/*static uint32 crc_32(uint8* input, int32 input_size)
+{
+	uint32 crc = c_crc_32_init;
+
+	uint8* input_end = &input[input_size];
+	for (; input != input_end; ++input)
+	{
+		crc ^= (*input << 24);
+		crc = (crc << 8) ^ s_crc_32_table[crc >> 24];
+	}
+
+	return crc ^ c_crc_32_xor_out;
+}*/
+
+static uint32 crc_32_ignore_case(uint8* input, int32 input_size)
+{
+	uint32 crc = c_crc_32_init;
+
+	uint8* input_end = &input[input_size];
+	for (; input != input_end; ++input)
+	{
+		crc ^= ((uint32)(uint8)char_to_lower(*input) << 24);
+		crc = (crc << 8) ^ s_crc_32_table[crc >> 24];
+	}
+
+	return crc ^ c_crc_32_xor_out;
+}
+
+void map_create(Map* map, int32 max_items, Linear_Allocator* allocator)
+{
+	map->node_pool = (Map::Node*)linear_allocator_alloc(allocator, sizeof(Map::Node) * max_items);
+	map->node_pool_size = max_items;
+	map->next_available_node = map->node_pool;
+	map->map_size = u32_max(u32_round_down_power_of_two(max_items), 4);
+	map->map_mask = map->map_size - 1;
+	map->map = (Map::Node*)linear_allocator_alloc(allocator, sizeof(Map::Node) * map->map_size);
+	for (int32 i = 0; i < map->map_size; ++i)
+	{
+		map->map[i] = {};
+	}
+}
+
+void map_add(Map* map, const char* key, void* value)
+{
+	assert(key);
+
+	uint32 hash = crc_32_ignore_case((uint8*)key, string_length(key));
+
+	assert(map->next_available_node != (map->node_pool + map->node_pool_size));
+
+	Map::Node* node = &map->map[hash & map->map_mask];
+	if (!node->key)
+	{
+		node->key = key;
+		node->value = value;
+	}
+	else
+	{
+		Map::Node* new_node = map->next_available_node++;
+		new_node->key = node->key;
+		new_node->value = node->value;
+		new_node->next = node->next;
+		node->key = key;
+		node->value = value;
+		node->next = new_node;
+	}
+}
+
+// like map_add, but if the key is already in the map its value is replaced instead
+void map_set(Map* map, const char* key, void* value)
+{
+	assert(key);
+
+	uint32 hash = crc_32_ignore_case((uint8*)key, string_length(key));
+	Map::Node* node = &map->map[hash & map->map_mask];
+
+	if (node->key)
+	{
+		Map::Node* iter = node;
+		do
+		{
+			if (string_equals_ignore_case(iter->key, key))
+			{
+				iter->value = value;
+				return;
+			}
+
+			iter = iter->next;
+		}
+		while (iter);
+
+		assert(map->next_available_node != (map->node_pool + map->node_pool_size));
+
+		Map::Node* new_node = map->next_available_node++;
+		new_node->key = node->key;
+		new_node->value = node->value;
+		new_node->next = node->next;
+		node->key = key;
+		node->value = value;
+		node->next = new_node;
+	}
+	else
+	{
+		node->key = key;
+		node->value = value;
+	}
+}
+
+void* map_find(Map* map, const char* key)
+{
+	assert(key);
+
+	return map_find(map, key, string_length(key));
+}
+
+// key doesn't need to be null terminated, so a key can be looked up by a prefix of a longer string without copying it
+void* map_find(Map* map, const char* key, int32 key_char_count)
+{
+	assert(key);
+
+	uint32 hash = crc_32_ignore_case((uint8*)key, key_char_count);
+	Map::Node* node = &map->map[hash & map->map_mask];
+	
+	if (node->key)
+	{
+		do
+		{
+			if (string_equals_ignore_case(node->key, key, key_char_count))
+			{
+				return node->value;
+			}
+
+			node = node->next;
+		}
+		while (node);
+	}
+
+	return nullptr;
+}
\ No newline at end of file
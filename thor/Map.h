@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Core.h"
+
+
+
+// string keyed (case insensitive) hash map, nodes come from a fixed size pool
+struct Map
+{
+	struct Node
+	{
+		const char* key;
+		void* value;
+		Node* next;
+	};
+
+	Node* node_pool;
+	int32 node_pool_size;
+	Node* next_available_node;
+	Node* map;
+	int32 map_size;
+	int32 map_mask;
+};// todo(jbr) fib index thing
+
+
+void map_create(Map* map, int32 max_items, struct Linear_Allocator* allocator);
+void map_add(Map* map, const char* key, void* value);
+void map_set(Map* map, const char* key, void* value);
+void* map_find(Map* map, const char* key);
+void* map_find(Map* map, const char* key, int32 key_char_count);
\ No newline at end of file
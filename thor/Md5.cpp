@@ -0,0 +1,285 @@
+#include "Md5.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define MD5_SSE2 1
+#include <emmintrin.h>
+#else
+#define MD5_SSE2 0
+#endif
+
+
+
+static const uint32 c_md5_k[64] = 
+{
+	0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+	0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+	0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+	0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+	0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+	0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+	0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+	0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+static const uint32 c_md5_shift[64] = 
+{
+	7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+	5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+	4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+	6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+// which message word each step uses
+static const uint32 c_md5_word_index[64] = 
+{
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+	1, 6, 11, 0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12,
+	5, 8, 11, 14, 1, 4, 7, 10, 13, 0, 3, 6, 9, 12, 15, 2,
+	0, 7, 14, 5, 12, 3, 10, 1, 8, 15, 6, 13, 4, 11, 2, 9
+};
+
+static const uint32 c_md5_init[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+
+
+static uint32 md5_load_u32(const uint8* bytes)
+{
+	// md5 is little endian regardless of platform
+	return (uint32)bytes[0] | ((uint32)bytes[1] << 8) | ((uint32)bytes[2] << 16) | ((uint32)bytes[3] << 24);
+}
+
+static void md5_block(uint32* state, const uint8* block)
+{
+	uint32 words[16];
+	for (uint32 i = 0; i < 16; ++i)
+	{
+		words[i] = md5_load_u32(&block[i * 4]);
+	}
+
+	uint32 a = state[0];
+	uint32 b = state[1];
+	uint32 c = state[2];
+	uint32 d = state[3];
+
+	for (uint32 i = 0; i < 64; ++i)
+	{
+		uint32 f;
+		if (i < 16)
+		{
+			f = (b & c) | (~b & d);
+		}
+		else if (i < 32)
+		{
+			f = (d & b) | (~d & c);
+		}
+		else if (i < 48)
+		{
+			f = b ^ c ^ d;
+		}
+		else
+		{
+			f = c ^ (b | ~d);
+		}
+
+		f += a + c_md5_k[i] + words[c_md5_word_index[i]];
+		a = d;
+		d = c;
+		c = b;
+		b += (f << c_md5_shift[i]) | (f >> (32 - c_md5_shift[i]));
+	}
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+}
+
+// the final 1 or 2 blocks, 0x80 after the data, zero padding, then length in bits
+static uint32 md5_build_tail(const uint8* bytes, uint32 byte_count, uint8* out_tail /*128 bytes*/)
+{
+	uint32 remainder = byte_count & 63;
+	const uint8* remainder_bytes = &bytes[byte_count - remainder];
+
+	uint32 tail_size = remainder < 56 ? 64 : 128;
+	for (uint32 i = 0; i < tail_size; ++i)
+	{
+		out_tail[i] = 0;
+	}
+	for (uint32 i = 0; i < remainder; ++i)
+	{
+		out_tail[i] = remainder_bytes[i];
+	}
+	out_tail[remainder] = 0x80;
+
+	uint64 bit_count = (uint64)byte_count * 8;
+	for (uint32 i = 0; i < 8; ++i)
+	{
+		out_tail[tail_size - 8 + i] = (uint8)(bit_count >> (i * 8));
+	}
+
+	return tail_size / 64;
+}
+
+static void md5_write_digest(const uint32* state, uint8* out_digest)
+{
+	for (uint32 i = 0; i < 4; ++i)
+	{
+		out_digest[(i * 4) + 0] = (uint8)(state[i]);
+		out_digest[(i * 4) + 1] = (uint8)(state[i] >> 8);
+		out_digest[(i * 4) + 2] = (uint8)(state[i] >> 16);
+		out_digest[(i * 4) + 3] = (uint8)(state[i] >> 24);
+	}
+}
+
+void md5(const uint8* bytes, uint32 byte_count, uint8* out_digest)
+{
+	uint32 state[4] = { c_md5_init[0], c_md5_init[1], c_md5_init[2], c_md5_init[3] };
+
+	uint32 full_block_count = byte_count / 64;
+	for (uint32 i = 0; i < full_block_count; ++i)
+	{
+		md5_block(state, &bytes[i * 64]);
+	}
+
+	uint8 tail[128];
+	uint32 tail_block_count = md5_build_tail(bytes, byte_count, tail);
+	for (uint32 i = 0; i < tail_block_count; ++i)
+	{
+		md5_block(state, &tail[i * 64]);
+	}
+
+	md5_write_digest(state, out_digest);
+}
+
+#if MD5_SSE2
+static __m128i md5_rotate_left(__m128i v, uint32 shift)
+{
+	return _mm_or_si128(_mm_slli_epi32(v, shift), _mm_srli_epi32(v, 32 - shift));
+}
+
+// one block from each of 4 inputs, each 32 bit lane of the state vectors belongs to one input
+static void md5_block_x4(__m128i* state, const uint8** blocks)
+{
+	__m128i words[16];
+	for (uint32 i = 0; i < 16; ++i)
+	{
+		words[i] = _mm_set_epi32(
+			(int32)md5_load_u32(&blocks[3][i * 4]), 
+			(int32)md5_load_u32(&blocks[2][i * 4]), 
+			(int32)md5_load_u32(&blocks[1][i * 4]), 
+			(int32)md5_load_u32(&blocks[0][i * 4]));
+	}
+
+	const __m128i all_ones = _mm_set1_epi32(-1);
+
+	__m128i a = state[0];
+	__m128i b = state[1];
+	__m128i c = state[2];
+	__m128i d = state[3];
+
+	for (uint32 i = 0; i < 64; ++i)
+	{
+		__m128i f;
+		if (i < 16)
+		{
+			f = _mm_or_si128(_mm_and_si128(b, c), _mm_andnot_si128(b, d));
+		}
+		else if (i < 32)
+		{
+			f = _mm_or_si128(_mm_and_si128(d, b), _mm_andnot_si128(d, c));
+		}
+		else if (i < 48)
+		{
+			f = _mm_xor_si128(_mm_xor_si128(b, c), d);
+		}
+		else
+		{
+			f = _mm_xor_si128(c, _mm_or_si128(b, _mm_xor_si128(d, all_ones)));
+		}
+
+		f = _mm_add_epi32(f, _mm_add_epi32(a, _mm_add_epi32(_mm_set1_epi32((int32)c_md5_k[i]), words[c_md5_word_index[i]])));
+		a = d;
+		d = c;
+		c = b;
+		b = _mm_add_epi32(b, md5_rotate_left(f, c_md5_shift[i]));
+	}
+
+	state[0] = _mm_add_epi32(state[0], a);
+	state[1] = _mm_add_epi32(state[1], b);
+	state[2] = _mm_add_epi32(state[2], c);
+	state[3] = _mm_add_epi32(state[3], d);
+}
+
+void md5_x4(const uint8** bytes, const uint32* byte_counts, uint8** out_digests)
+{
+	__m128i state[4];
+	for (uint32 i = 0; i < 4; ++i)
+	{
+		state[i] = _mm_set1_epi32((int32)c_md5_init[i]);
+	}
+
+	uint8 tails[4][128];
+	uint32 full_block_counts[4];
+	uint32 block_counts[4];
+	uint32 max_block_count = 0;
+	for (uint32 lane = 0; lane < 4; ++lane)
+	{
+		full_block_counts[lane] = byte_counts[lane] / 64;
+		block_counts[lane] = full_block_counts[lane] + md5_build_tail(bytes[lane], byte_counts[lane], tails[lane]);
+		if (block_counts[lane] > max_block_count)
+		{
+			max_block_count = block_counts[lane];
+		}
+	}
+
+	// lanes which finish early keep hashing their last block, the result is taken before that happens
+	uint32 lane_states[4][4];
+	for (uint32 block_i = 0; block_i < max_block_count; ++block_i)
+	{
+		const uint8* blocks[4];
+		for (uint32 lane = 0; lane < 4; ++lane)
+		{
+			uint32 lane_block_i = block_i < block_counts[lane] ? block_i : block_counts[lane] - 1;
+			if (lane_block_i < full_block_counts[lane])
+			{
+				blocks[lane] = &bytes[lane][lane_block_i * 64];
+			}
+			else
+			{
+				blocks[lane] = &tails[lane][(lane_block_i - full_block_counts[lane]) * 64];
+			}
+		}
+
+		md5_block_x4(state, blocks);
+
+		for (uint32 lane = 0; lane < 4; ++lane)
+		{
+			if (block_i == block_counts[lane] - 1)
+			{
+				uint32 words[4][4];
+				for (uint32 i = 0; i < 4; ++i)
+				{
+					_mm_storeu_si128((__m128i*)words[i], state[i]);
+				}
+
+				for (uint32 i = 0; i < 4; ++i)
+				{
+					lane_states[lane][i] = words[i][lane];
+				}
+			}
+		}
+	}
+
+	for (uint32 lane = 0; lane < 4; ++lane)
+	{
+		md5_write_digest(lane_states[lane], out_digests[lane]);
+	}
+}
+#else
+void md5_x4(const uint8** bytes, const uint32* byte_counts, uint8** out_digests)
+{
+	for (uint32 lane = 0; lane < 4; ++lane)
+	{
+		md5(bytes[lane], byte_counts[lane], out_digests[lane]);
+	}
+}
+#endif
\ No newline at end of file
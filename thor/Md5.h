@@ -0,0 +1,8 @@
+#pragma once
+
+#include "Core.h"
+
+
+
+void md5(const uint8* bytes, uint32 byte_count, uint8* out_digest /*16 bytes*/);
+void md5_x4(const uint8** bytes, const uint32* byte_counts, uint8** out_digests); // hashes 4 independent inputs at once, fastest when they're a similar size
\ No newline at end of file
@@ -73,4 +73,13 @@ bool bytes_equal(const uint8* a, const uint8* b, uint32 byte_count)
 	}
 
 	return true;
+}
+
+void bytes_copy(uint8* dst, const uint8* src, uint32 byte_count)
+{
+	const uint8* src_end = &src[byte_count];
+	for (; src != src_end; ++src, ++dst)
+	{
+		*dst = *src;
+	}
 }
\ No newline at end of file
@@ -24,4 +24,5 @@ void linear_allocator_destroy_sub_allocator(Linear_Allocator* linear_allocator,
 void linear_allocator_destroy(Linear_Allocator* linear_allocator);
 void linear_allocator_reset(Linear_Allocator* linear_allocator);
 uint8* linear_allocator_alloc(Linear_Allocator* linear_allocator, uint32 size);
-bool bytes_equal(const uint8* a, const uint8* b, uint32 byte_count); // todo(jbr) is this the right place for this?
\ No newline at end of file
+bool bytes_equal(const uint8* a, const uint8* b, uint32 byte_count); // todo(jbr) is this the right place for this?
+void bytes_copy(uint8* dst, const uint8* src, uint32 byte_count);
\ No newline at end of file
@@ -1,131 +1,1783 @@
 #include "Pigg_File.h"
 
-#include "File.h"
+#include "Buffer.h"
+#include "Md5.h"
 #include "Memory.h"
 #include "String.h"
+#include "Thread.h"
 #include "Zlib.h"
 
 
 
-struct Pigg_Entry
-{
-	uint32 sig;
-	uint32 name_id;
-	uint32 file_size;
-	uint32 timestamp;
-	uint32 offset;
-	uint32 unknown;
-	uint32 header_id;
-	uint8 md5[16];
-	uint32 compressed_size;
-};
-constexpr uint32 c_invalid_id = (uint32)-1; // for string/slot ids
+constexpr uint32 c_pigg_reader_buffer_size = kilobytes(64);
 
+// the tables come straight from the file, so every count and size is checked against what's left of the file 
+// before it's used
+static bool32 pigg_reader_has_bytes(File_Reader* reader, uint64 byte_count)
+{
+	return byte_count <= reader->file_size - file_reader_get_position(reader);
+}
 
-void unpack_pigg_file(const char* file_name, Linear_Allocator* allocator)
+// returns false if the file can't be opened or its tables are corrupt, in which case nothing is taken from allocator
+bool32 pigg_open(Pigg_Archive* out_archive, const char* file_name, Linear_Allocator* allocator)
 {
+	*out_archive = {};
+
 	File_Handle file = file_open_read(file_name);
+	if (!file_is_valid(file))
+	{
+		return false;
+	}
 
-	uint32 file_sig = file_read_u32(file);
-	assert(file_sig == c_pigg_file_sig);
-	file_skip(file, 2); //uint16 unknown
-	file_skip(file, 2); //uint16 version
-	uint16 header_size = file_read_u16(file);
-	assert(header_size == 16);
-	uint16 used_header_bytes = file_read_u16(file);
-	assert(used_header_bytes == 48);
-	uint32 entry_count = file_read_u32(file);
+	// the tables are read a field at a time, so go through a buffer
+	uint8 reader_buffer[c_pigg_reader_buffer_size];
+	File_Reader reader;
+	file_reader_create(&reader, file, reader_buffer, sizeof(reader_buffer));
 
-	Pigg_Entry* entries = (Pigg_Entry*)linear_allocator_alloc(allocator, sizeof(Pigg_Entry) * entry_count);
+	// everything goes in a copy of the allocator, which is only kept if the whole table is good
+	Linear_Allocator archive_allocator = *allocator;
+	bool32 is_valid = pigg_reader_has_bytes(&reader, 16);
 
-	for (uint32 i = 0; i < entry_count; ++i)
+	uint32 entry_count = 0;
+	if (is_valid)
+	{
+		uint32 file_sig = file_reader_read_u32(&reader);
+		file_reader_skip(&reader, 2); //uint16 unknown
+		file_reader_skip(&reader, 2); //uint16 version
+		uint16 header_size = file_reader_read_u16(&reader);
+		uint16 used_header_bytes = file_reader_read_u16(&reader);
+		entry_count = file_reader_read_u32(&reader);
+
+		is_valid = file_sig == c_pigg_file_sig && 
+			header_size == 16 && 
+			used_header_bytes == 48 && 
+			pigg_reader_has_bytes(&reader, (uint64)entry_count * 48);
+	}
+
+	Pigg_Entry* entries = is_valid && entry_count ? (Pigg_Entry*)linear_allocator_alloc(&archive_allocator, sizeof(Pigg_Entry) * entry_count) : nullptr;
+
+	for (uint32 i = 0; is_valid && i < entry_count; ++i)
 	{
 		Pigg_Entry* entry = &entries[i];
 
-		entry->sig = file_read_u32(file);
-		assert(entry->sig == c_internal_file_sig);
-		entry->name_id = file_read_u32(file);
-		entry->file_size = file_read_u32(file);
-		entry->timestamp = file_read_u32(file);
-		entry->offset = file_read_u32(file);
-		entry->unknown = file_read_u32(file);
-		entry->header_id = file_read_u32(file);
-		file_read(file, 16, entry->md5);
-		entry->compressed_size = file_read_u32(file);
+		entry->sig = file_reader_read_u32(&reader);
+		entry->name_id = file_reader_read_u32(&reader);
+		entry->file_size = file_reader_read_u32(&reader);
+		entry->timestamp = file_reader_read_u32(&reader);
+		entry->offset = file_reader_read_u32(&reader);
+		entry->unknown = file_reader_read_u32(&reader);
+		entry->header_id = file_reader_read_u32(&reader);
+		file_reader_read(&reader, 16, entry->md5);
+		entry->compressed_size = file_reader_read_u32(&reader);
+
+		is_valid = entry->sig == c_internal_file_sig;
 	}
 
-	uint32 file_names_table_sig = file_read_u32(file);
-	assert(file_names_table_sig == c_string_table_sig);
-	uint32 file_names_table_count = file_read_u32(file);
-	uint32 file_names_table_size = file_read_u32(file);
+	uint32 file_names_table_count = 0;
+	uint32 file_names_table_size = 0;
+	if (is_valid)
+	{
+		is_valid = pigg_reader_has_bytes(&reader, 12);
+	}
+	if (is_valid)
+	{
+		uint32 file_names_table_sig = file_reader_read_u32(&reader);
+		file_names_table_count = file_reader_read_u32(&reader);
+		file_names_table_size = file_reader_read_u32(&reader);
+
+		is_valid = file_names_table_sig == c_string_table_sig && 
+			file_names_table_size >= (uint64)file_names_table_count * 4 && 
+			pigg_reader_has_bytes(&reader, file_names_table_size);
+	}
 
-	char** file_names = (char**)linear_allocator_alloc(allocator, sizeof(char *) * file_names_table_count);
+	const char** file_names = nullptr;
+	char* file_names_data = nullptr;
 	uint32 file_names_data_size = file_names_table_size - (file_names_table_count * 4);
-	char* file_names_data = (char*)linear_allocator_alloc(allocator, sizeof(char) * file_names_data_size);
+	if (is_valid && file_names_table_count)
+	{
+		file_names = (const char**)linear_allocator_alloc(&archive_allocator, sizeof(char *) * file_names_table_count);
+		file_names_data = file_names_data_size ? (char*)linear_allocator_alloc(&archive_allocator, sizeof(char) * file_names_data_size) : nullptr;
+	}
 	
 	uint32 num_table_bytes_read = 0;
-	for (uint32 i = 0; i < file_names_table_count; ++i)
+	for (uint32 i = 0; is_valid && i < file_names_table_count; ++i)
 	{
-		uint32 string_length = file_read_u32(file);
-		assert(string_length <= (file_names_data_size - num_table_bytes_read));
+		uint32 string_length = file_reader_read_u32(&reader);
 
-		file_read(file, string_length, &file_names_data[num_table_bytes_read]);
+		// names are looked up as strings, so each needs its terminator inside the table
+		is_valid = string_length && string_length <= (file_names_data_size - num_table_bytes_read);
+		if (is_valid)
+		{
+			file_reader_read(&reader, string_length, &file_names_data[num_table_bytes_read]);
+			is_valid = file_names_data[num_table_bytes_read + string_length - 1] == 0;
+		}
 
 		file_names[i] = &file_names_data[num_table_bytes_read];
 
 		num_table_bytes_read += string_length;
 	}
 
-	constexpr uint32 c_in_buffer_size = megabytes(8);
-	constexpr uint32 c_out_buffer_size = megabytes(128);
+	// file header table, stored the same way as the name table but rows are binary
+	uint32 header_table_count = 0;
+	uint32 header_table_size = 0;
+	if (is_valid)
+	{
+		is_valid = pigg_reader_has_bytes(&reader, 12);
+	}
+	if (is_valid)
+	{
+		uint32 header_table_sig = file_reader_read_u32(&reader);
+		header_table_count = file_reader_read_u32(&reader);
+		header_table_size = file_reader_read_u32(&reader);
+
+		is_valid = header_table_sig == c_meta_table_sig && 
+			header_table_size >= (uint64)header_table_count * 4 && 
+			pigg_reader_has_bytes(&reader, header_table_size);
+	}
+
+	const uint8** headers = nullptr;
+	uint32* header_sizes = nullptr;
+	uint8* headers_data = nullptr;
+	uint32 headers_data_size = header_table_size - (header_table_count * 4);
+	if (is_valid && header_table_count)
+	{
+		headers = (const uint8**)linear_allocator_alloc(&archive_allocator, sizeof(uint8*) * header_table_count);
+		header_sizes = (uint32*)linear_allocator_alloc(&archive_allocator, sizeof(uint32) * header_table_count);
+		headers_data = headers_data_size ? linear_allocator_alloc(&archive_allocator, headers_data_size) : nullptr;
+	}
+
+	num_table_bytes_read = 0;
+	for (uint32 i = 0; is_valid && i < header_table_count; ++i)
+	{
+		uint32 row_size = file_reader_read_u32(&reader);
+
+		// pigg_read_header needs at least the size field at the start of the row
+		is_valid = row_size >= 4 && row_size <= (headers_data_size - num_table_bytes_read);
+		if (is_valid)
+		{
+			file_reader_read(&reader, row_size, &headers_data[num_table_bytes_read]);
+		}
+
+		headers[i] = &headers_data[num_table_bytes_read];
+		header_sizes[i] = row_size;
+
+		num_table_bytes_read += row_size;
+	}
+
+	// ids from the entry table have to land in the tables above
+	for (uint32 i = 0; is_valid && i < entry_count; ++i)
+	{
+		is_valid = entries[i].name_id < file_names_table_count && 
+			(entries[i].header_id == c_invalid_id || entries[i].header_id < header_table_count);
+	}
+
+	if (!is_valid)
+	{
+		file_close(file);
+		return false;
+	}
 
-	uint8* in_buffer = (uint8*)linear_allocator_alloc(allocator, sizeof(uint8) * c_in_buffer_size);
-	uint8* out_buffer = (uint8*)linear_allocator_alloc(allocator, sizeof(uint8) * c_out_buffer_size);
+	out_archive->file = file;
+	out_archive->size = file_size(file);
+	out_archive->entries = entries;
+	out_archive->entry_count = entry_count;
+	out_archive->file_names = file_names;
+	out_archive->file_name_count = file_names_table_count;
+	out_archive->headers = headers;
+	out_archive->header_sizes = header_sizes;
+	out_archive->header_count = header_table_count;
 
+	map_create(&out_archive->entry_map, /*max_items*/ u32_max(entry_count, 1), &archive_allocator);
 	for (uint32 i = 0; i < entry_count; ++i)
 	{
-		Pigg_Entry* entry = &entries[i];
+		map_add(&out_archive->entry_map, file_names[entries[i].name_id], &entries[i]);
+	}
+
+	*allocator = archive_allocator;
+
+	return true;
+}
+
+void pigg_close(Pigg_Archive* archive)
+{
+	file_mapping_close(&archive->mapping);
+	file_close(archive->file);
+	*archive = {};
+}
+
+Pigg_Entry* pigg_find_entry(Pigg_Archive* archive, const char* path)
+{
+	// names in the pigg have no leading slash
+	if (*path == '/')
+	{
+		++path;
+	}
+
+	return (Pigg_Entry*)map_find(&archive->entry_map, path);
+}
+
+const char* pigg_entry_name(Pigg_Archive* archive, Pigg_Entry* entry)
+{
+	assert(entry->name_id < archive->file_name_count);
+	return archive->file_names[entry->name_id];
+}
+
+bool32 pigg_open_mapped(Pigg_Archive* out_archive, const char* file_name, Linear_Allocator* allocator)
+{
+	if (!pigg_open(out_archive, file_name, allocator))
+	{
+		return false;
+	}
 
-		assert(entry->compressed_size <= c_in_buffer_size);
-		assert(entry->file_size <= c_out_buffer_size);
+	// if the mapping fails then mapping.bytes stays null and reads fall back to going through the file handle
+	file_mapping_open(&out_archive->mapping, out_archive->file);
 
-		file_set_position(file, entry->offset);
+	return true;
+}
 
+// entry tables come straight from the file, so a corrupt one could point anywhere
+static bool32 pigg_entry_is_in_bounds(Pigg_Archive* archive, Pigg_Entry* entry)
+{
+	uint64 size_in_pigg = entry->compressed_size ? entry->compressed_size : entry->file_size;
+	return (uint64)entry->offset + size_in_pigg <= archive->size;
+}
+
+// null if the entry's data isn't inside the mapping
+static const uint8* pigg_mapped_entry_bytes(Pigg_Archive* archive, Pigg_Entry* entry)
+{
+	if (!pigg_entry_is_in_bounds(archive, entry))
+	{
+		return nullptr;
+	}
+
+	return &archive->mapping.bytes[entry->offset];
+}
+
+// hint that up to byte_count bytes from the start of an entry's data will be read soon
+void pigg_prefetch(Pigg_Archive* archive, Pigg_Entry* entry, uint32 byte_count)
+{
+	if (!pigg_entry_is_in_bounds(archive, entry))
+	{
+		return;
+	}
+
+	uint32 size_in_pigg = entry->compressed_size ? entry->compressed_size : entry->file_size;
+	if (byte_count > size_in_pigg)
+	{
+		byte_count = size_in_pigg;
+	}
+
+	if (archive->mapping.bytes)
+	{
+		file_mapping_prefetch(&archive->mapping, entry->offset, byte_count);
+	}
+	else if (byte_count)
+	{
+		file_prefetch(archive->file, entry->offset, byte_count);
+	}
+}
+
+// returns null for empty entries, entries whose data isn't inside the pigg or doesn't inflate to file_size, and 
+// entries there isn't room for in allocator. Nothing is left in allocator when null is returned
+uint8* pigg_read(Pigg_Archive* archive, Pigg_Entry* entry, Linear_Allocator* allocator)
+{
+	// empty files have nothing to read, and nothing to allocate
+	if (!entry->file_size || !pigg_entry_is_in_bounds(archive, entry))
+	{
+		return nullptr;
+	}
+
+	// file_size comes from the table too, so check there's room rather than let the allocator assert
+	uint64 read_size = (uint64)entry->file_size + (archive->mapping.bytes ? 0 : entry->compressed_size);
+	if (read_size > allocator->bytes_available)
+	{
+		return nullptr;
+	}
+
+	// only kept if the entry reads and inflates ok
+	Linear_Allocator read_allocator = *allocator;
+	uint8* inflated = linear_allocator_alloc(&read_allocator, entry->file_size);
+
+	// positioned reads when there's no mapping, so several threads can read from the same archive
+	const uint8* deflated = nullptr;
+	if (archive->mapping.bytes)
+	{
+		const uint8* bytes = pigg_mapped_entry_bytes(archive, entry);
 		if (entry->compressed_size == 0)
 		{
-			file_read(file, entry->file_size, out_buffer);
+			bytes_copy(inflated, bytes, entry->file_size);
 		}
-		else
-		{
-			assert(entry->compressed_size != entry->file_size); // I *think* uncompressed data will have compressed_size of 0, but asserting in case I'm wrong
+		deflated = bytes;
+	}
+	else if (entry->compressed_size == 0)
+	{
+		file_read_at(archive->file, entry->offset, entry->file_size, inflated);
+	}
+	else
+	{
+		// deflated bytes only need to live until they're inflated, so take them from a copy of 
+		// the allocator, the space is handed back as soon as this function returns
+		Linear_Allocator deflated_allocator = read_allocator;
+		uint8* read_bytes = linear_allocator_alloc(&deflated_allocator, entry->compressed_size);
+		file_read_at(archive->file, entry->offset, entry->compressed_size, read_bytes);
+		deflated = read_bytes;
+	}
+
+	if (entry->compressed_size && 
+		zlib_inflate_bytes_checked(/*context*/ nullptr, deflated, entry->compressed_size, inflated, entry->file_size) != Zlib_Result::Ok)
+	{
+		return nullptr;
+	}
 
-			file_read(file, entry->compressed_size, in_buffer);
+	*allocator = read_allocator;
+	return inflated;
+}
 
-			zlib_inflate_bytes(in_buffer, entry->compressed_size, out_buffer, entry->file_size);
+// reads several entries with all the reads in flight at once. Without a thread pool each entry is inflated 
+// as soon as its read completes, with one everything is inflated across the pool once all the reads are done. 
+// read_queue and thread_pool are optional. Same as pigg_read, out_bytes is null for entries which are empty, out 
+// of bounds or corrupt, or there isn't room for
+void pigg_read_batch(Pigg_Archive* archive, Pigg_Entry** entries, uint32 entry_count, File_Read_Queue* read_queue, Thread_Pool* thread_pool, Linear_Allocator* allocator, uint8** out_bytes)
+{
+	if (archive->mapping.bytes && !thread_pool)
+	{
+		for (uint32 i = 0; i < entry_count; ++i)
+		{
+			out_bytes[i] = pigg_read(archive, entries[i], allocator);
 		}
+		return;
+	}
+
+	// the requests, inflate jobs and the pool's inflate contexts come out of what's left after the entries, so 
+	// set that aside before working out which entries there's room for (sizes come from the table, so could be anything)
+	uint64 batch_size = 0;
+	if (!archive->mapping.bytes)
+	{
+		batch_size += sizeof(File_Read_Request) * (uint64)u32_max(entry_count, 1);
+	}
+	if (thread_pool)
+	{
+		batch_size += (sizeof(Zlib_Inflate_Job) * (uint64)u32_max(entry_count, 1)) + 
+			((sizeof(Zlib_Inflate_Context) + zlib_inflate_context_size()) * (uint64)thread_pool->worker_count);
+	}
+
+	uint64 bytes_available = batch_size <= allocator->bytes_available ? allocator->bytes_available - batch_size : 0;
+	for (uint32 i = 0; i < entry_count; ++i)
+	{
+		Pigg_Entry* entry = entries[i];
+		bool32 is_readable = batch_size <= allocator->bytes_available && 
+			entry->file_size && 
+			entry->file_size <= bytes_available && 
+			pigg_entry_is_in_bounds(archive, entry);
+
+		out_bytes[i] = is_readable ? linear_allocator_alloc(allocator, entry->file_size) : nullptr;
+		bytes_available -= is_readable ? entry->file_size : 0;
+	}
+
+	if (batch_size > allocator->bytes_available)
+	{
+		return;
+	}
+
+	// same as pigg_read, the requests and deflated bytes are handed back when this function returns
+	Linear_Allocator deflated_allocator = *allocator;
+	File_Read_Request* requests = nullptr;
 
-		assert(entry->name_id < file_names_table_count);
+	if (!archive->mapping.bytes)
+	{
+		requests = (File_Read_Request*)linear_allocator_alloc(&deflated_allocator, sizeof(File_Read_Request) * u32_max(entry_count, 1));
+
+		for (uint32 i = 0; i < entry_count; ++i)
+		{
+			Pigg_Entry* entry = entries[i];
+
+			// entries with nothing to read still get a (zero byte) request, so they complete along with the rest
+			requests[i] = {};
+			requests[i].file = archive->file;
+			requests[i].position = entry->offset;
+			if (out_bytes[i] && entry->compressed_size == 0)
+			{
+				requests[i].byte_count = entry->file_size;
+				requests[i].bytes = out_bytes[i];
+			}
+			else if (out_bytes[i] && entry->compressed_size <= bytes_available)
+			{
+				requests[i].byte_count = entry->compressed_size;
+				requests[i].bytes = linear_allocator_alloc(&deflated_allocator, entry->compressed_size);
+				bytes_available -= entry->compressed_size;
+			}
+			else
+			{
+				out_bytes[i] = nullptr;
+			}
+		}
 
-		char path_buffer[512];
-		string_concat(path_buffer, sizeof(path_buffer), "unpacked/", file_names[entry->name_id]);
+		file_read_submit(read_queue, requests, entry_count);
+	}
 
-		for (uint32 string_i = 0; path_buffer[string_i]; ++string_i)
+	if (!thread_pool)
+	{
+		for (uint32 i = 0; i < entry_count; ++i)
 		{
-			if (path_buffer[string_i] == '/')
+			file_read_wait(read_queue, &requests[i], 1);
+
+			Pigg_Entry* entry = entries[i];
+			if (out_bytes[i] && entry->compressed_size && 
+				zlib_inflate_bytes_checked(/*context*/ nullptr, (uint8*)requests[i].bytes, entry->compressed_size, out_bytes[i], entry->file_size) != Zlib_Result::Ok)
 			{
-				// temporarily terminate string here to create directory, then reinstate it after
-				path_buffer[string_i] = 0;
+				out_bytes[i] = nullptr;
+			}
+		}
+		return;
+	}
+
+	if (requests)
+	{
+		file_read_wait(read_queue, requests, entry_count);
+	}
+
+	Zlib_Inflate_Job* jobs = (Zlib_Inflate_Job*)linear_allocator_alloc(&deflated_allocator, sizeof(Zlib_Inflate_Job) * u32_max(entry_count, 1));
+	uint32 job_count = 0;
+
+	for (uint32 i = 0; i < entry_count; ++i)
+	{
+		Pigg_Entry* entry = entries[i];
+		if (!out_bytes[i])
+		{
+			continue;
+		}
 
-				dir_create(path_buffer);
+		const uint8* bytes = requests ? (const uint8*)requests[i].bytes : pigg_mapped_entry_bytes(archive, entry);
 
-				path_buffer[string_i] = '/';
+		if (entry->compressed_size == 0)
+		{
+			if (!requests)
+			{
+				bytes_copy(out_bytes[i], bytes, entry->file_size);
 			}
+			continue;
 		}
 
-		File_Handle out_file = file_open_write(path_buffer);
-		file_write_bytes(out_file, entry->file_size, out_buffer);
-		file_close(out_file);
+		Zlib_Inflate_Job* job = &jobs[job_count++];
+		*job = {};
+		job->deflated_bytes = bytes;
+		job->deflated_bytes_size = entry->compressed_size;
+		job->out_inflated_bytes = out_bytes[i];
+		job->inflated_bytes_size = entry->file_size;
 	}
 
-	file_close(file);
+	uint32 failed_count = zlib_inflate_batch(jobs, job_count, thread_pool, &deflated_allocator);
+	if (!failed_count)
+	{
+		return;
+	}
+
+	// jobs were made in entry order, so walk them again to find which entries they were for
+	uint32 job_i = 0;
+	for (uint32 i = 0; i < entry_count; ++i)
+	{
+		if (out_bytes[i] && entries[i]->compressed_size && jobs[job_i++].result != Zlib_Result::Ok)
+		{
+			out_bytes[i] = nullptr;
+		}
+	}
+}
+
+// for mapped archives, stored entries come back as a pointer straight into the mapping (so only valid 
+// until pigg_close) and compressed entries are inflated from the mapping, nothing is allocated for stored 
+// entries. Unmapped archives just do a pigg_read. Null for entries whose data isn't inside the pigg
+const uint8* pigg_read_mapped(Pigg_Archive* archive, Pigg_Entry* entry, Linear_Allocator* allocator)
+{
+	if (archive->mapping.bytes && entry->compressed_size == 0)
+	{
+		return pigg_mapped_entry_bytes(archive, entry);
+	}
+
+	return pigg_read(archive, entry, allocator);
+}
+
+// some entries (e.g. geos) have the start of the file duplicated in the header table, so it can be 
+// looked at without reading and inflating the whole thing. Returns null for entries without a header, and 
+// for headers which are corrupt or there isn't room for in allocator
+uint8* pigg_read_header(Pigg_Archive* archive, Pigg_Entry* entry, Linear_Allocator* allocator, uint32* out_size)
+{
+	*out_size = 0;
+
+	if (entry->header_id == c_invalid_id)
+	{
+		return nullptr;
+	}
+
+	// pigg_open checks header_id, and that every row is at least big enough for header_size
+	assert(entry->header_id < archive->header_count);
+
+	uint8* row = (uint8*)archive->headers[entry->header_id];
+	uint32 row_size = archive->header_sizes[entry->header_id];
+
+	uint32 header_size = buffer_read_u32(&row);
+	uint32 row_data_size;
+	uint32 inflated_size = 0;
+	if (header_size == row_size)
+	{
+		// stored uncompressed, rest of the row is the header
+		row_data_size = row_size - 4;
+	}
+	else
+	{
+		if (row_size < 8)
+		{
+			return nullptr;
+		}
+
+		// if inflated_size is 0 then it's marked as compressed, but isn't really
+		inflated_size = buffer_read_u32(&row);
+		row_data_size = row_size - 8;
+	}
+
+	uint32 size = inflated_size ? inflated_size : row_data_size;
+	if (!size || size > allocator->bytes_available)
+	{
+		return nullptr;
+	}
+
+	// only kept if the header inflates ok
+	Linear_Allocator header_allocator = *allocator;
+	uint8* header = linear_allocator_alloc(&header_allocator, size);
+
+	if (!inflated_size)
+	{
+		bytes_copy(header, row, size);
+	}
+	else if (zlib_inflate_bytes_checked(/*context*/ nullptr, row, row_data_size, header, inflated_size) != Zlib_Result::Ok)
+	{
+		return nullptr;
+	}
+
+	*allocator = header_allocator;
+	*out_size = size;
+	return header;
+}
+
+uint8* pigg_read(Pigg_Archive* archive, const char* path, Linear_Allocator* allocator, uint32* out_size)
+{
+	Pigg_Entry* entry = pigg_find_entry(archive, path);
+	if (!entry)
+	{
+		*out_size = 0;
+		return nullptr;
+	}
+
+	uint8* bytes = pigg_read(archive, entry, allocator);
+	*out_size = bytes ? entry->file_size : 0;
+
+	return bytes;
+}
+
+struct Pigg_Path
+{
+	const char* path;
+	Pigg_Path* next;
+};
+
+struct Pigg_Search_State
+{
+	Pigg_Path* paths;
+	int32 path_count;
+	Linear_Allocator* allocator;
+};
+
+static void on_pigg_file_found(const char* path, void* state)
+{
+	Pigg_Search_State* search_state = (Pigg_Search_State*)state;
+
+	// keep the list sorted so that mount order doesn't depend on the order the OS lists directories in
+	Pigg_Path** insert_at = &search_state->paths;
+	while (*insert_at && string_compare_ignore_case((*insert_at)->path, path) < 0)
+	{
+		insert_at = &(*insert_at)->next;
+	}
+
+	Pigg_Path* pigg_path = (Pigg_Path*)linear_allocator_alloc(search_state->allocator, sizeof(Pigg_Path));
+	pigg_path->path = string_copy(path, search_state->allocator);
+	pigg_path->next = *insert_at;
+	*insert_at = pigg_path;
+
+	++search_state->path_count;
+}
+
+void pigg_mount_create(Pigg_Mount* out_mount, const char* piggs_path, Linear_Allocator* allocator, Linear_Allocator* temp_allocator)
+{
+	Pigg_Search_State search_state = {};
+	search_state.allocator = temp_allocator;
+	file_search(piggs_path, "*.pigg", /*include_subdirs*/ true, on_pigg_file_found, &search_state);
+
+	*out_mount = {};
+	out_mount->archive_count = search_state.path_count;
+	out_mount->archives = search_state.path_count ? (Pigg_Archive*)linear_allocator_alloc(allocator, sizeof(Pigg_Archive) * search_state.path_count) : nullptr;
+
+	int32 total_entry_count = 0;
+	Pigg_Archive* archive = out_mount->archives;
+	for (Pigg_Path* pigg_path = search_state.paths; pigg_path; pigg_path = pigg_path->next)
+	{
+		// a corrupt pigg is left out, rather than taking the rest of the mount down with it
+		if (!pigg_open_mapped(archive, pigg_path->path, allocator))
+		{
+			continue;
+		}
+
+		total_entry_count += archive->entry_count;
+		++archive;
+	}
+	out_mount->archive_count = (int32)(archive - out_mount->archives);
+
+	out_mount->file_count = total_entry_count;
+	out_mount->files = total_entry_count ? (Pigg_Mount_File*)linear_allocator_alloc(allocator, sizeof(Pigg_Mount_File) * total_entry_count) : nullptr;
+	map_create(&out_mount->file_map, /*max_items*/ u32_max(total_entry_count, 1), allocator);
+
+	// archives are in mount order, so map_set means later archives replace files from earlier ones
+	Pigg_Mount_File* file = out_mount->files;
+	Pigg_Archive* archive_end = &out_mount->archives[out_mount->archive_count];
+	for (archive = out_mount->archives; archive != archive_end; ++archive)
+	{
+		Pigg_Entry* entry_end = &archive->entries[archive->entry_count];
+		for (Pigg_Entry* entry = archive->entries; entry != entry_end; ++entry)
+		{
+			file->archive = archive;
+			file->entry = entry;
+
+			map_set(&out_mount->file_map, pigg_entry_name(archive, entry), file);
+
+			++file;
+		}
+	}
+}
+
+void pigg_mount_destroy(Pigg_Mount* mount)
+{
+	for (int32 i = 0; i < mount->archive_count; ++i)
+	{
+		pigg_close(&mount->archives[i]);
+	}
+
+	*mount = {};
+}
+
+Pigg_Mount_File* pigg_mount_find(Pigg_Mount* mount, const char* path)
+{
+	if (*path == '/')
+	{
+		++path;
+	}
+
+	return (Pigg_Mount_File*)map_find(&mount->file_map, path);
+}
+
+// returns null (and an out_size of 0) for paths which aren't in the mount, and for entries pigg_read can't read 
+// because they're empty, out of bounds, corrupt, or there isn't room for them in allocator
+uint8* pigg_mount_read(Pigg_Mount* mount, const char* path, Linear_Allocator* allocator, uint32* out_size)
+{
+	*out_size = 0;
+
+	Pigg_Mount_File* file = pigg_mount_find(mount, path);
+	if (!file)
+	{
+		return nullptr;
+	}
+
+	uint8* bytes = pigg_read(file->archive, file->entry, allocator);
+	if (bytes)
+	{
+		*out_size = file->entry->file_size;
+	}
+
+	return bytes;
+}
+
+enum class Pigg_Sort_Key
+{
+	Offset, // so whoever works through entries in order is reading the pigg sequentially
+	File_Size
+};
+
+static uint32 pigg_entry_sort_key(Pigg_Entry* entry, Pigg_Sort_Key sort_key)
+{
+	return sort_key == Pigg_Sort_Key::Offset ? entry->offset : entry->file_size;
+}
+
+// radix sort of entry indices
+static uint32* pigg_sort_entries(Pigg_Archive* archive, Pigg_Sort_Key sort_key, Linear_Allocator* allocator)
+{
+	uint32 entry_count = archive->entry_count;
+	uint32* sorted = (uint32*)linear_allocator_alloc(allocator, sizeof(uint32) * entry_count);
+	uint32* temp = (uint32*)linear_allocator_alloc(allocator, sizeof(uint32) * entry_count);
+
+	for (uint32 i = 0; i < entry_count; ++i)
+	{
+		sorted[i] = i;
+	}
+
+	for (uint32 shift = 0; shift < 32; shift += 8)
+	{
+		uint32 counts[256] = {};
+		for (uint32 i = 0; i < entry_count; ++i)
+		{
+			++counts[(pigg_entry_sort_key(&archive->entries[sorted[i]], sort_key) >> shift) & 0xff];
+		}
+
+		uint32 total = 0;
+		for (uint32 i = 0; i < 256; ++i)
+		{
+			uint32 count = counts[i];
+			counts[i] = total;
+			total += count;
+		}
+
+		for (uint32 i = 0; i < entry_count; ++i)
+		{
+			temp[counts[(pigg_entry_sort_key(&archive->entries[sorted[i]], sort_key) >> shift) & 0xff]++] = sorted[i];
+		}
+
+		uint32* swap = sorted;
+		sorted = temp;
+		temp = swap;
+	}
+
+	// 4 passes, so the result has ended up back in the first array
+	return sorted;
+}
+
+constexpr uint32 c_unpack_chunk_size = kilobytes(256);
+
+struct Unpack_Worker
+{
+	File_Handle file; // each worker has its own handle so reads don't contend, not used when the pigg is mapped
+	uint8* in_buffer; // both c_unpack_chunk_size
+	uint8* out_buffer;
+	Zlib_Inflate_Context inflate_context; // reset for each entry
+};
+
+struct Unpack_Manifest_Row
+{
+	const char* name;
+	uint32 file_size;
+	uint32 timestamp;
+	uint8 md5[16];
+};
+
+struct Unpack_State
+{
+	Pigg_Archive* archive;
+	uint32* sorted_entry_indices;
+	Unpack_Worker* workers;
+	uint32 flags;
+	Map manifest_map; // name -> Unpack_Manifest_Row*, only used for incremental unpacks
+	bool32* is_entry_failed; // corrupt entries, these are skipped and left out of the manifest
+	volatile int32 written_count;
+	volatile int32 failed_count;
+};
+
+constexpr uint32 c_unpack_manifest_sig = 0x4e414d55; // "UMAN"
+constexpr uint32 c_unpack_manifest_version = 1;
+
+// manifest records what was last unpacked from a pigg, so the next incremental unpack knows what it can skip
+static void unpack_manifest_path(char* out_path, uint32 out_path_size, const char* pigg_file_name)
+{
+	int32 last_slash = string_find_last(pigg_file_name, '/');
+	int32 last_backslash = string_find_last(pigg_file_name, '\\');
+	int32 name_start = (last_slash > last_backslash ? last_slash : last_backslash) + 1;
+
+	int32 length = string_concat(out_path, out_path_size, "unpacked/", &pigg_file_name[name_start]);
+	string_copy(&out_path[length], out_path_size - length, ".manifest");
+}
+
+static void unpack_manifest_read(const char* manifest_path, Map* out_manifest_map, Linear_Allocator* allocator)
+{
+	*out_manifest_map = {};
+
+	File_Handle file = file_open_read(manifest_path);
+	if (!file_is_valid(file))
+	{
+		map_create(out_manifest_map, /*max_items*/ 1, allocator);
+		return;
+	}
+
+	uint32 size = (uint32)file_size(file);
+	uint8* bytes = linear_allocator_alloc(allocator, u32_max(size, 1));
+	file_read(file, size, bytes);
+	file_close(file);
+
+	uint8* bytes_iter = bytes;
+	uint8* bytes_end = bytes + size;
+
+	uint32 row_count = 0;
+	if (size >= 12 && 
+		buffer_read_u32(&bytes_iter) == c_unpack_manifest_sig && 
+		buffer_read_u32(&bytes_iter) == c_unpack_manifest_version)
+	{
+		row_count = buffer_read_u32(&bytes_iter);
+	}
+
+	// a missing or out of date manifest just means everything gets unpacked
+	map_create(out_manifest_map, /*max_items*/ u32_max(row_count, 1), allocator);
+	Unpack_Manifest_Row* rows = row_count ? (Unpack_Manifest_Row*)linear_allocator_alloc(allocator, sizeof(Unpack_Manifest_Row) * row_count) : nullptr;
+
+	for (uint32 i = 0; i < row_count; ++i)
+	{
+		if ((uint32)(bytes_end - bytes_iter) < 4)
+		{
+			break;
+		}
+
+		uint32 name_size = buffer_read_u32(&bytes_iter);
+		if ((uint32)(bytes_end - bytes_iter) < name_size + 24 || !name_size || bytes_iter[name_size - 1])
+		{
+			break;
+		}
+
+		Unpack_Manifest_Row* row = &rows[i];
+		row->name = (const char*)bytes_iter;
+		buffer_skip(&bytes_iter, name_size);
+		row->file_size = buffer_read_u32(&bytes_iter);
+		row->timestamp = buffer_read_u32(&bytes_iter);
+		buffer_read_bytes(&bytes_iter, 16, row->md5);
+
+		map_set(out_manifest_map, row->name, row);
+	}
+}
+
+// entries which failed to unpack are left out, so the next incremental unpack has another go at them
+static void unpack_manifest_write(const char* manifest_path, Pigg_Archive* archive, const bool32* is_entry_failed, Linear_Allocator* temp_allocator)
+{
+	uint32 size = 12;
+	uint32 row_count = 0;
+	for (uint32 i = 0; i < archive->entry_count; ++i)
+	{
+		if (!is_entry_failed[i])
+		{
+			size += 4 + string_length(pigg_entry_name(archive, &archive->entries[i])) + 1 + 24;
+			++row_count;
+		}
+	}
+
+	uint8* bytes = linear_allocator_alloc(temp_allocator, size);
+	uint8* bytes_iter = bytes;
+
+	buffer_write_u32(&bytes_iter, c_unpack_manifest_sig);
+	buffer_write_u32(&bytes_iter, c_unpack_manifest_version);
+	buffer_write_u32(&bytes_iter, row_count);
+
+	for (uint32 i = 0; i < archive->entry_count; ++i)
+	{
+		if (is_entry_failed[i])
+		{
+			continue;
+		}
+
+		Pigg_Entry* entry = &archive->entries[i];
+		const char* name = pigg_entry_name(archive, entry);
+		uint32 name_size = string_length(name) + 1; // incl null
+
+		buffer_write_u32(&bytes_iter, name_size);
+		buffer_write_bytes(&bytes_iter, name_size, (const uint8*)name);
+		buffer_write_u32(&bytes_iter, entry->file_size);
+		buffer_write_u32(&bytes_iter, entry->timestamp);
+		buffer_write_bytes(&bytes_iter, 16, entry->md5);
+	}
+
+	assert(bytes_iter == bytes + size);
+
+	File_Handle file = file_open_write(manifest_path);
+	assert(file_is_valid(file));
+	file_write_bytes(file, size, bytes);
+	file_close(file);
+}
+
+static bool32 unpack_is_entry_unchanged(Unpack_State* unpack_state, Pigg_Entry* entry, const char* out_path)
+{
+	Unpack_Manifest_Row* row = (Unpack_Manifest_Row*)map_find(&unpack_state->manifest_map, pigg_entry_name(unpack_state->archive, entry));
+	if (!row || 
+		row->file_size != entry->file_size || 
+		row->timestamp != entry->timestamp)
+	{
+		return false;
+	}
+
+	if ((unpack_state->flags & c_unpack_compare_md5) && !bytes_equal(row->md5, entry->md5, 16))
+	{
+		return false;
+	}
+
+	// the manifest could be stale if someone has deleted or modified files since
+	File_Handle out_file = file_open_read(out_path);
+	if (!file_is_valid(out_file))
+	{
+		return false;
+	}
+
+	uint64 out_file_size = file_size(out_file);
+	file_close(out_file);
+
+	return out_file_size == entry->file_size;
+}
+
+static void unpack_pigg_entry(uint32 item_index, int32 worker_index, void* state)
+{
+	Unpack_State* unpack_state = (Unpack_State*)state;
+	Unpack_Worker* worker = &unpack_state->workers[worker_index];
+	Pigg_Archive* archive = unpack_state->archive;
+	uint32 entry_index = unpack_state->sorted_entry_indices[item_index];
+	Pigg_Entry* entry = &archive->entries[entry_index];
+
+	// uncompressed data has a compressed_size of 0, so a compressed_size which matches file_size is treated as 
+	// corrupt, same as an entry whose data is outside the pigg. Both are checked before anything else is looked up
+	if ((entry->compressed_size && entry->compressed_size == entry->file_size) || 
+		!pigg_entry_is_in_bounds(archive, entry))
+	{
+		unpack_state->is_entry_failed[entry_index] = true;
+		atomic_increment(&unpack_state->failed_count);
+		return;
+	}
+
+	char path_buffer[512];
+	string_concat(path_buffer, sizeof(path_buffer), "unpacked/", pigg_entry_name(archive, entry));
+
+	if ((unpack_state->flags & c_unpack_incremental) && unpack_is_entry_unchanged(unpack_state, entry, path_buffer))
+	{
+		return;
+	}
+
+	for (uint32 string_i = 0; path_buffer[string_i]; ++string_i)
+	{
+		if (path_buffer[string_i] == '/')
+		{
+			// temporarily terminate string here to create directory, then reinstate it after
+			path_buffer[string_i] = 0;
+
+			dir_create(path_buffer);
+
+			path_buffer[string_i] = '/';
+		}
+	}
+
+	File_Handle out_file = file_open_write(path_buffer);
+
+	// data is read, inflated and written a chunk at a time so memory use doesn't depend on entry size
+	const uint8* in_bytes = nullptr;
+	uint32 in_byte_count = 0;
+	uint32 in_position = entry->offset;
+	uint32 in_bytes_remaining = entry->compressed_size ? entry->compressed_size : entry->file_size;
+
+	if (archive->mapping.bytes)
+	{
+		in_bytes = pigg_mapped_entry_bytes(archive, entry);
+		in_byte_count = in_bytes_remaining;
+		in_bytes_remaining = 0;
+
+		file_mapping_prefetch(&archive->mapping, entry->offset, in_byte_count);
+	}
+	else if (in_bytes_remaining)
+	{
+		// chunks are read one after another, so get the OS reading ahead of them
+		file_prefetch(archive->file, entry->offset, in_bytes_remaining);
+	}
+
+	bool32 is_failed = false;
+
+	if (entry->compressed_size == 0)
+	{
+		if (in_byte_count)
+		{
+			file_write_bytes(out_file, in_byte_count, in_bytes);
+		}
+
+		while (in_bytes_remaining)
+		{
+			uint32 chunk_size = in_bytes_remaining < c_unpack_chunk_size ? in_bytes_remaining : c_unpack_chunk_size;
+			file_read_at(worker->file, in_position, chunk_size, worker->in_buffer);
+			file_write_bytes(out_file, chunk_size, worker->in_buffer);
+
+			in_position += chunk_size;
+			in_bytes_remaining -= chunk_size;
+		}
+	}
+	else
+	{
+		Zlib_Inflate_Stream stream;
+		zlib_inflate_stream_begin(&stream, &worker->inflate_context);
+
+		uint32 total_bytes_inflated = 0;
+		bool32 is_finished = false;
+		while (!is_finished)
+		{
+			if (!in_byte_count && in_bytes_remaining)
+			{
+				uint32 chunk_size = in_bytes_remaining < c_unpack_chunk_size ? in_bytes_remaining : c_unpack_chunk_size;
+				file_read_at(worker->file, in_position, chunk_size, worker->in_buffer);
+
+				in_bytes = worker->in_buffer;
+				in_byte_count = chunk_size;
+				in_position += chunk_size;
+				in_bytes_remaining -= chunk_size;
+			}
+
+			uint32 bytes_consumed;
+			uint32 bytes_inflated;
+			Zlib_Result result = zlib_inflate_stream(&stream, in_bytes, in_byte_count, &bytes_consumed, worker->out_buffer, c_unpack_chunk_size, &bytes_inflated, &is_finished);
+
+			// bad data, no progress (which means the data is truncated), or more data than the entry says
+			total_bytes_inflated += bytes_inflated;
+			if (result != Zlib_Result::Ok || 
+				(!is_finished && !bytes_consumed && !bytes_inflated) || 
+				total_bytes_inflated > entry->file_size)
+			{
+				is_failed = true;
+				break;
+			}
+
+			in_bytes += bytes_consumed;
+			in_byte_count -= bytes_consumed;
+
+			if (bytes_inflated)
+			{
+				file_write_bytes(out_file, bytes_inflated, worker->out_buffer);
+			}
+		}
+
+		zlib_inflate_stream_end(&stream);
+
+		if (total_bytes_inflated != entry->file_size)
+		{
+			is_failed = true;
+		}
+	}
+
+	file_close(out_file);
+
+	// don't leave a partial file behind, it could look like a good one to whatever reads it next
+	if (is_failed)
+	{
+		file_delete(path_buffer);
+		unpack_state->is_entry_failed[entry_index] = true;
+		atomic_increment(&unpack_state->failed_count);
+		return;
+	}
+
+	atomic_increment(&unpack_state->written_count);
+}
+
+// thread_pool is optional, without one everything is unpacked on the calling thread, returns the number of files written. 
+// Entries which are corrupt are skipped rather than stopping the whole unpack, out_failed_count (optional) is how many. 
+// A pigg which can't be opened at all has nothing written, and counts as one failure
+uint32 unpack_pigg_file(const char* file_name, uint32 flags, Thread_Pool* thread_pool, Linear_Allocator* allocator, uint32* out_failed_count)
+{
+	Pigg_Archive archive;
+	if (!pigg_open_mapped(&archive, file_name, allocator))
+	{
+		if (out_failed_count)
+		{
+			*out_failed_count = 1;
+		}
+		return 0;
+	}
+
+	bool32 is_mapped = archive.mapping.bytes != nullptr;
+
+	int32 worker_count = thread_pool ? thread_pool->worker_count : 1;
+
+	Unpack_State unpack_state = {};
+	unpack_state.archive = &archive;
+	unpack_state.sorted_entry_indices = pigg_sort_entries(&archive, Pigg_Sort_Key::Offset, allocator);
+	unpack_state.workers = (Unpack_Worker*)linear_allocator_alloc(allocator, sizeof(Unpack_Worker) * worker_count);
+	unpack_state.flags = flags;
+	unpack_state.is_entry_failed = (bool32*)linear_allocator_alloc(allocator, sizeof(bool32) * u32_max(archive.entry_count, 1));
+
+	for (uint32 i = 0; i < archive.entry_count; ++i)
+	{
+		unpack_state.is_entry_failed[i] = false;
+	}
+
+	dir_create("unpacked");
+
+	char manifest_path[512];
+	unpack_manifest_path(manifest_path, sizeof(manifest_path), file_name);
+	if (flags & c_unpack_incremental)
+	{
+		unpack_manifest_read(manifest_path, &unpack_state.manifest_map, allocator);
+	}
+
+	for (int32 i = 0; i < worker_count; ++i)
+	{
+		Unpack_Worker* worker = &unpack_state.workers[i];
+		*worker = {};
+
+		if (!is_mapped)
+		{
+			worker->file = i == 0 ? archive.file : file_open_read(file_name);
+			assert(file_is_valid(worker->file));
+			worker->in_buffer = linear_allocator_alloc(allocator, c_unpack_chunk_size);
+		}
+
+		worker->out_buffer = linear_allocator_alloc(allocator, c_unpack_chunk_size);
+		zlib_inflate_context_create(&worker->inflate_context, allocator);
+	}
+
+	if (thread_pool)
+	{
+		thread_pool_run(thread_pool, archive.entry_count, unpack_pigg_entry, &unpack_state);
+	}
+	else
+	{
+		for (uint32 i = 0; i < archive.entry_count; ++i)
+		{
+			unpack_pigg_entry(i, /*worker_index*/ 0, &unpack_state);
+		}
+	}
+
+	if (!is_mapped)
+	{
+		for (int32 i = 1; i < worker_count; ++i)
+		{
+			file_close(unpack_state.workers[i].file);
+		}
+	}
+
+	unpack_manifest_write(manifest_path, &archive, unpack_state.is_entry_failed, allocator);
+
+	pigg_close(&archive);
+
+	if (out_failed_count)
+	{
+		*out_failed_count = unpack_state.failed_count;
+	}
+
+	return unpack_state.written_count;
+}
+
+struct Verify_Worker
+{
+	Linear_Allocator allocator;
+};
+
+struct Verify_State
+{
+	Pigg_Archive* archive;
+	uint32* sorted_entry_indices;
+	Verify_Worker* workers;
+	bool32* is_entry_bad;
+	File_Read_Queue* read_queue;
+};
+
+// each item is a group of 4 entries (of similar size, as they're sorted by size) which get hashed together
+static void verify_pigg_entries(uint32 item_index, int32 worker_index, void* state)
+{
+	Verify_State* verify_state = (Verify_State*)state;
+	Verify_Worker* worker = &verify_state->workers[worker_index];
+	Pigg_Archive* archive = verify_state->archive;
+
+	linear_allocator_reset(&worker->allocator);
+
+	uint32 first = item_index * 4;
+	uint32 count = archive->entry_count - first < 4 ? archive->entry_count - first : 4;
+
+	// entries whose data is outside the pigg are bad without reading anything, an empty entry is hashed in their place
+	Pigg_Entry empty_entry = {};
+	uint32 entry_indices[4];
+	bool32 is_out_of_bounds[4];
+	Pigg_Entry* entries[4];
+	const uint8* bytes[4];
+	uint32 byte_counts[4];
+	uint8 digests[4][16];
+	uint8* out_digests[4] = { digests[0], digests[1], digests[2], digests[3] };
+	for (uint32 i = 0; i < 4; ++i)
+	{
+		// if the last group is short then just hash the first entry again in the spare lanes
+		entry_indices[i] = verify_state->sorted_entry_indices[first + (i < count ? i : 0)];
+		entries[i] = &archive->entries[entry_indices[i]];
+		is_out_of_bounds[i] = !pigg_entry_is_in_bounds(archive, entries[i]);
+		if (is_out_of_bounds[i])
+		{
+			entries[i] = &empty_entry;
+		}
+		byte_counts[i] = entries[i]->file_size;
+	}
+
+	if (archive->mapping.bytes)
+	{
+		for (uint32 i = 0; i < 4; ++i)
+		{
+			bytes[i] = entries[i]->file_size ? pigg_read_mapped(archive, entries[i], &worker->allocator) : nullptr;
+		}
+	}
+	else
+	{
+		// all of the group's reads go out together rather than one after another
+		uint8* read_bytes[4];
+		pigg_read_batch(archive, entries, count, verify_state->read_queue, /*thread_pool*/ nullptr, &worker->allocator, read_bytes);
+
+		for (uint32 i = 0; i < 4; ++i)
+		{
+			bytes[i] = read_bytes[i < count ? i : 0];
+		}
+	}
+
+	// entries which didn't read or inflate are bad too, and also hashed as empty
+	bool32 is_unreadable[4];
+	for (uint32 i = 0; i < 4; ++i)
+	{
+		is_unreadable[i] = is_out_of_bounds[i] || (byte_counts[i] && !bytes[i]);
+		if (is_unreadable[i])
+		{
+			byte_counts[i] = 0;
+		}
+	}
+
+	md5_x4(bytes, byte_counts, out_digests);
+
+	for (uint32 i = 0; i < count; ++i)
+	{
+		if (is_unreadable[i] || !bytes_equal(digests[i], entries[i]->md5, 16))
+		{
+			verify_state->is_entry_bad[entry_indices[i]] = true;
+		}
+	}
+}
+
+// hashes every entry and compares with the md5 stored in the pigg, entries which don't match go in out_bad_entries. 
+// thread_pool and read_queue are optional. Each worker holds a group of the biggest entries at once, if there isn't 
+// room in allocator for that across the whole pool then the entries are all verified on the calling thread instead. 
+// Returns false, without verifying anything, if there isn't room for even that
+bool32 pigg_verify(Pigg_Archive* archive, Thread_Pool* thread_pool, File_Read_Queue* read_queue, Linear_Allocator* allocator, Pigg_Entry*** out_bad_entries, uint32* out_bad_entry_count)
+{
+	*out_bad_entries = nullptr;
+	*out_bad_entry_count = 0;
+
+	if (!archive->entry_count)
+	{
+		return true;
+	}
+
+	uint64 max_file_size = 0;
+	uint64 max_compressed_size = 0;
+	for (uint32 i = 0; i < archive->entry_count; ++i)
+	{
+		// out of bounds entries aren't read, see verify_pigg_entries
+		if (pigg_entry_is_in_bounds(archive, &archive->entries[i]))
+		{
+			max_file_size = archive->entries[i].file_size > max_file_size ? archive->entries[i].file_size : max_file_size;
+			max_compressed_size = archive->entries[i].compressed_size > max_compressed_size ? archive->entries[i].compressed_size : max_compressed_size;
+		}
+	}
+
+	// enough for 4 inflated entries, plus the deflated bytes and read requests for them if the archive isn't mapped. 
+	// Sizes come from the entry table, so this is worked out in 64 bits where it can't wrap
+	uint64 worker_allocator_size = ((max_file_size + max_compressed_size) * 4) + (sizeof(File_Read_Request) * 4) + 64;
+
+	// the sort (which needs twice the space of its result), the bad entry flags, and the bad entry list if every entry is bad
+	uint64 state_size = ((sizeof(uint32) * 2) + sizeof(bool32) + sizeof(Pigg_Entry*)) * (uint64)archive->entry_count;
+
+	int32 worker_count = thread_pool ? thread_pool->worker_count : 1;
+	if (state_size + ((sizeof(Verify_Worker) + worker_allocator_size) * worker_count) > allocator->bytes_available)
+	{
+		thread_pool = nullptr;
+		worker_count = 1;
+
+		if (state_size + sizeof(Verify_Worker) + worker_allocator_size > allocator->bytes_available)
+		{
+			return false;
+		}
+	}
+
+	Verify_State verify_state = {};
+	verify_state.archive = archive;
+	verify_state.sorted_entry_indices = pigg_sort_entries(archive, Pigg_Sort_Key::File_Size, allocator);
+	verify_state.workers = (Verify_Worker*)linear_allocator_alloc(allocator, sizeof(Verify_Worker) * worker_count);
+	verify_state.read_queue = read_queue;
+	verify_state.is_entry_bad = (bool32*)linear_allocator_alloc(allocator, sizeof(bool32) * archive->entry_count);
+
+	for (uint32 i = 0; i < archive->entry_count; ++i)
+	{
+		verify_state.is_entry_bad[i] = false;
+	}
+
+	for (int32 i = 0; i < worker_count; ++i)
+	{
+		linear_allocator_create_sub_allocator(allocator, &verify_state.workers[i].allocator, (uint32)worker_allocator_size);
+	}
+
+	uint32 group_count = (archive->entry_count + 3) / 4;
+	if (thread_pool)
+	{
+		thread_pool_run(thread_pool, group_count, verify_pigg_entries, &verify_state);
+	}
+	else
+	{
+		for (uint32 i = 0; i < group_count; ++i)
+		{
+			verify_pigg_entries(i, /*worker_index*/ 0, &verify_state);
+		}
+	}
+
+	uint32 bad_entry_count = 0;
+	for (uint32 i = 0; i < archive->entry_count; ++i)
+	{
+		if (verify_state.is_entry_bad[i])
+		{
+			++bad_entry_count;
+		}
+	}
+
+	if (bad_entry_count)
+	{
+		Pigg_Entry** bad_entries = (Pigg_Entry**)linear_allocator_alloc(allocator, sizeof(Pigg_Entry*) * bad_entry_count);
+		Pigg_Entry** bad_entry_iter = bad_entries;
+		for (uint32 i = 0; i < archive->entry_count; ++i)
+		{
+			if (verify_state.is_entry_bad[i])
+			{
+				*bad_entry_iter++ = &archive->entries[i];
+			}
+		}
+
+		*out_bad_entries = bad_entries;
+		*out_bad_entry_count = bad_entry_count;
+	}
+
+	return true;
+}
+
+struct Pack_Item
+{
+	const char* name;
+	Pigg_Entry entry; // what gets written for this item, offset/name_id/header_id are for the new pigg
+	Pigg_Archive* source_archive; // item comes from either an entry in an archive, or a file on disk
+	Pigg_Entry* source_entry;
+	const char* source_path;
+	const uint8* header; // raw header table row, if any
+	uint32 header_size;
+	bool32 is_ordered;
+};
+
+static uint32 pigg_pack_align(uint32 offset, uint32 alignment)
+{
+	if (alignment <= 1)
+	{
+		return offset;
+	}
+
+	return ((offset + alignment - 1) / alignment) * alignment;
+}
+
+static void pigg_pack_write(const char* out_file_name, Pack_Item* items, uint32 item_count, Pigg_Pack_Options* options, Linear_Allocator* temp_allocator)
+{
+	// items in the trace go first in trace order, everything else keeps its order after that
+	Pack_Item** ordered_items = (Pack_Item**)linear_allocator_alloc(temp_allocator, sizeof(Pack_Item*) * u32_max(item_count, 1));
+	uint32 ordered_item_count = 0;
+
+	if (options && options->trace_count)
+	{
+		Map item_map;
+		map_create(&item_map, /*max_items*/ u32_max(item_count, 1), temp_allocator);
+		for (uint32 i = 0; i < item_count; ++i)
+		{
+			map_set(&item_map, items[i].name, &items[i]);
+		}
+
+		for (int32 i = 0; i < options->trace_count; ++i)
+		{
+			const char* path = options->trace[i];
+			if (*path == '/')
+			{
+				++path;
+			}
+
+			Pack_Item* item = (Pack_Item*)map_find(&item_map, path);
+			if (item && !item->is_ordered)
+			{
+				item->is_ordered = true;
+				ordered_items[ordered_item_count++] = item;
+			}
+		}
+	}
+
+	for (uint32 i = 0; i < item_count; ++i)
+	{
+		if (!items[i].is_ordered)
+		{
+			ordered_items[ordered_item_count++] = &items[i];
+		}
+	}
+	assert(ordered_item_count == item_count);
+
+	// work out where everything goes, names and headers are written in the same order as the data
+	uint32 name_table_size = 0;
+	uint32 header_table_size = 0;
+	uint32 header_count = 0;
+	for (uint32 i = 0; i < item_count; ++i)
+	{
+		Pack_Item* item = ordered_items[i];
+
+		item->entry.sig = c_internal_file_sig;
+		item->entry.name_id = i;
+		name_table_size += 4 + string_length(item->name) + 1;
+
+		if (item->header)
+		{
+			item->entry.header_id = header_count++;
+			header_table_size += 4 + item->header_size;
+		}
+		else
+		{
+			item->entry.header_id = c_invalid_id;
+		}
+	}
+
+	uint32 tables_size = 16 + (item_count * 48) + (12 + name_table_size) + (12 + header_table_size);
+	uint32 alignment = options ? options->alignment : 0;
+	int32 deflate_level = options ? options->deflate_level : c_zlib_deflate_level_store;
+
+	// data goes first, deflated sizes aren't known until each file is deflated. The tables are the same size 
+	// whatever goes in them, so space is left for them at the start and they're written last
+	File_Handle out_file = file_open_write(out_file_name);
+	assert(file_is_valid(out_file));
+
+	uint8 padding[4096] = {};
+	uint32 position = 0;
+	for (uint32 i = 0; i < item_count; ++i)
+	{
+		Pack_Item* item = ordered_items[i];
+
+		uint32 offset = pigg_pack_align(position > tables_size ? position : tables_size, alignment);
+		while (position < offset)
+		{
+			uint32 padding_size = offset - position < sizeof(padding) ? offset - position : sizeof(padding);
+			file_write_bytes(out_file, padding_size, padding);
+			position += padding_size;
+		}
+		item->entry.offset = offset;
+
+		// each item's data only needs to live until it's written
+		Linear_Allocator item_allocator = *temp_allocator;
+
+		uint32 size_in_pigg = item->entry.compressed_size ? item->entry.compressed_size : item->entry.file_size;
+		if (!size_in_pigg)
+		{
+			continue;
+		}
+
+		const uint8* bytes;
+		if (item->source_archive)
+		{
+			// copy the bytes as they are in the source, compressed or not
+			if (item->source_archive->mapping.bytes)
+			{
+				bytes = pigg_mapped_entry_bytes(item->source_archive, item->source_entry);
+			}
+			else
+			{
+				uint8* read_bytes = linear_allocator_alloc(&item_allocator, size_in_pigg);
+				file_read_at(item->source_archive->file, item->source_entry->offset, size_in_pigg, read_bytes);
+				bytes = read_bytes;
+			}
+		}
+		else
+		{
+			File_Handle source_file = file_open_read(item->source_path);
+			uint8* read_bytes = linear_allocator_alloc(&item_allocator, size_in_pigg);
+			file_read(source_file, size_in_pigg, read_bytes);
+			file_close(source_file);
+			bytes = read_bytes;
+
+			if (deflate_level != c_zlib_deflate_level_store)
+			{
+				uint32 deflated_capacity = zlib_deflate_bound(size_in_pigg);
+				uint8* deflated_bytes = linear_allocator_alloc(&item_allocator, deflated_capacity);
+				uint32 deflated_size = zlib_deflate_bytes(bytes, size_in_pigg, deflate_level, deflated_bytes, deflated_capacity, &item_allocator);
+
+				// only keep it if it's smaller, unpacking also takes compressed_size == file_size to be a mistake
+				if (deflated_size && deflated_size < size_in_pigg)
+				{
+					item->entry.compressed_size = deflated_size;
+					size_in_pigg = deflated_size;
+					bytes = deflated_bytes;
+				}
+			}
+		}
+
+		file_write_bytes(out_file, size_in_pigg, bytes);
+		position += size_in_pigg;
+	}
+
+	// build everything up to the data in memory so it goes out in one write, over the space left for it
+	uint8* tables = linear_allocator_alloc(temp_allocator, tables_size);
+	uint8* tables_iter = tables;
+
+	buffer_write_u32(&tables_iter, c_pigg_file_sig);
+	buffer_write_u16(&tables_iter, 0); // unknown
+	buffer_write_u16(&tables_iter, 2); // version
+	buffer_write_u16(&tables_iter, 16); // header_size
+	buffer_write_u16(&tables_iter, 48); // used_header_bytes
+	buffer_write_u32(&tables_iter, item_count);
+
+	for (uint32 i = 0; i < item_count; ++i)
+	{
+		Pigg_Entry* entry = &ordered_items[i]->entry;
+
+		buffer_write_u32(&tables_iter, entry->sig);
+		buffer_write_u32(&tables_iter, entry->name_id);
+		buffer_write_u32(&tables_iter, entry->file_size);
+		buffer_write_u32(&tables_iter, entry->timestamp);
+		buffer_write_u32(&tables_iter, entry->offset);
+		buffer_write_u32(&tables_iter, entry->unknown);
+		buffer_write_u32(&tables_iter, entry->header_id);
+		buffer_write_bytes(&tables_iter, 16, entry->md5);
+		buffer_write_u32(&tables_iter, entry->compressed_size);
+	}
+
+	buffer_write_u32(&tables_iter, c_string_table_sig);
+	buffer_write_u32(&tables_iter, item_count);
+	buffer_write_u32(&tables_iter, name_table_size);
+	for (uint32 i = 0; i < item_count; ++i)
+	{
+		uint32 name_size = string_length(ordered_items[i]->name) + 1; // incl null
+		buffer_write_u32(&tables_iter, name_size);
+		buffer_write_bytes(&tables_iter, name_size, (const uint8*)ordered_items[i]->name);
+	}
+
+	buffer_write_u32(&tables_iter, c_meta_table_sig);
+	buffer_write_u32(&tables_iter, header_count);
+	buffer_write_u32(&tables_iter, header_table_size);
+	for (uint32 i = 0; i < item_count; ++i)
+	{
+		if (ordered_items[i]->header)
+		{
+			buffer_write_u32(&tables_iter, ordered_items[i]->header_size);
+			buffer_write_bytes(&tables_iter, ordered_items[i]->header_size, ordered_items[i]->header);
+		}
+	}
+
+	assert(tables_iter == tables + tables_size);
+
+	file_set_position(out_file, 0);
+	file_write_bytes(out_file, tables_size, tables);
+
+	file_close(out_file);
+}
+
+// writes a copy of source into a new pigg, entries keep their compression as is
+void pigg_pack_archive(const char* out_file_name, Pigg_Archive* source, Pigg_Pack_Options* options, Linear_Allocator* temp_allocator)
+{
+	Pack_Item* items = (Pack_Item*)linear_allocator_alloc(temp_allocator, sizeof(Pack_Item) * u32_max(source->entry_count, 1));
+
+	// without a trace, keep the order the data was in
+	uint32* sorted_entry_indices = pigg_sort_entries(source, Pigg_Sort_Key::Offset, temp_allocator);
+
+	uint32 item_count = 0;
+	for (uint32 i = 0; i < source->entry_count; ++i)
+	{
+		Pigg_Entry* source_entry = &source->entries[sorted_entry_indices[i]];
+
+		// there's nothing to copy for an entry whose data isn't in the source, so it's left out
+		if (!pigg_entry_is_in_bounds(source, source_entry))
+		{
+			continue;
+		}
+
+		Pack_Item* item = &items[item_count++];
+		*item = {};
+		item->name = pigg_entry_name(source, source_entry);
+		item->entry = *source_entry;
+		item->source_archive = source;
+		item->source_entry = source_entry;
+
+		if (source_entry->header_id != c_invalid_id)
+		{
+			assert(source_entry->header_id < source->header_count);
+			item->header = source->headers[source_entry->header_id];
+			item->header_size = source->header_sizes[source_entry->header_id];
+		}
+	}
+
+	pigg_pack_write(out_file_name, items, item_count, options, temp_allocator);
+}
+
+// merge sort of search result indices by path, ignoring case like the mount does, so a pigg packed from a 
+// directory doesn't depend on the order the OS (and the search threads) found its files in
+static uint32* pigg_sort_search_results(File_Search_Results* search_results, Linear_Allocator* allocator)
+{
+	uint32 count = search_results->path_count;
+	uint32* sorted = (uint32*)linear_allocator_alloc(allocator, sizeof(uint32) * u32_max(count, 1));
+	uint32* temp = (uint32*)linear_allocator_alloc(allocator, sizeof(uint32) * u32_max(count, 1));
+
+	for (uint32 i = 0; i < count; ++i)
+	{
+		sorted[i] = i;
+	}
+
+	for (uint32 run_size = 1; run_size < count; run_size *= 2)
+	{
+		for (uint32 start = 0; start < count; start += run_size * 2)
+		{
+			uint32 middle = start + run_size < count ? start + run_size : count;
+			uint32 end = start + (run_size * 2) < count ? start + (run_size * 2) : count;
+
+			uint32 left = start;
+			uint32 right = middle;
+			for (uint32 i = start; i < end; ++i)
+			{
+				if (left < middle && (right >= end || 
+					string_compare_ignore_case(file_search_result_path(search_results, sorted[left]), file_search_result_path(search_results, sorted[right])) <= 0))
+				{
+					temp[i] = sorted[left++];
+				}
+				else
+				{
+					temp[i] = sorted[right++];
+				}
+			}
+		}
+
+		uint32* swap = sorted;
+		sorted = temp;
+		temp = swap;
+	}
+
+	return sorted;
+}
+
+// packs every file under dir_path (which becomes the root of the pigg), files are deflated at options->deflate_level 
+// (or stored if that's c_zlib_deflate_level_store, or there are no options), thread_pool is optional and only 
+// used to scan dir_path. .geo files also get a header table row, see pigg_read_header. Returns false without 
+// writing anything if temp memory ran out before the whole of dir_path was found
+bool32 pigg_pack_dir(const char* out_file_name, const char* dir_path, Pigg_Pack_Options* options, Thread_Pool* thread_pool, Linear_Allocator* temp_allocator)
+{
+	// the search works in the back half of temp memory, and the results (which are always smaller than what 
+	// the search needed to find them) go at the front
+	File_Search_Results search_results;
+	{
+		Linear_Allocator search_temp_allocator = *temp_allocator;
+		linear_allocator_alloc(&search_temp_allocator, search_temp_allocator.bytes_available / 2);
+		file_search_parallel(&search_results, dir_path, "*", /*include_subdirs*/ true, thread_pool, temp_allocator, &search_temp_allocator);
+	}
+
+	// a pigg missing some of the directory would look fine until something in it was needed
+	if (search_results.is_truncated)
+	{
+		return false;
+	}
+
+	uint32* sorted_path_indices = pigg_sort_search_results(&search_results, temp_allocator);
+
+	Pack_Item* items = (Pack_Item*)linear_allocator_alloc(temp_allocator, sizeof(Pack_Item) * u32_max(search_results.path_count, 1));
+	uint32 item_count = 0;
+
+	int32 dir_path_length = string_length(dir_path);
+
+	for (uint32 path_i = 0; path_i < search_results.path_count; ++path_i)
+	{
+		const char* path = file_search_result_path(&search_results, sorted_path_indices[path_i]);
+
+		File_Handle file = file_open_read(path);
+		assert(file_is_valid(file));
+		if (!file_is_valid(file))
+		{
+			continue;
+		}
+
+		Pack_Item* item = &items[item_count++];
+		*item = {};
+		item->name = &path[dir_path_length + 1]; // skip dir_path and the slash after it
+		item->source_path = path;
+
+		// pigg sizes and offsets are 32 bit
+		uint64 size = file_size(file);
+		assert(size <= 0xffffffff);
+		item->entry.file_size = (uint32)size;
+		item->entry.timestamp = file_get_timestamp(file);
+
+		// geos get the start of the file, up to the end of the compressed header, as a header table row
+		// so their model list can be read without the data (see pigg_read_header and geo_header_read).
+		// The row has to outlive the file's bytes, so it's allocated first
+		uint32 geo_header_size = 0;
+		int32 extension_index = string_find_last(item->name, '.');
+		if (extension_index >= 0 && string_equals_ignore_case(&item->name[extension_index], ".geo") && item->entry.file_size >= 8)
+		{
+			geo_header_size = file_read_u32(file) + 4;
+			file_set_position(file, 0);
+
+			if (geo_header_size < 8 || geo_header_size > item->entry.file_size)
+			{
+				geo_header_size = 0;
+			}
+			else
+			{
+				// stored uncompressed, which is a row starting with its own size
+				uint8* header = linear_allocator_alloc(temp_allocator, 4 + geo_header_size);
+				uint8* header_iter = header;
+				buffer_write_u32(&header_iter, 4 + geo_header_size);
+
+				item->header = header;
+				item->header_size = 4 + geo_header_size;
+			}
+		}
+
+		// hash now, file contents only need to be in memory briefly
+		Linear_Allocator file_allocator = *temp_allocator;
+		uint8* bytes = item->entry.file_size ? linear_allocator_alloc(&file_allocator, item->entry.file_size) : nullptr;
+		file_read(file, item->entry.file_size, bytes);
+		md5(bytes, item->entry.file_size, item->entry.md5);
+
+		if (geo_header_size)
+		{
+			bytes_copy((uint8*)&item->header[4], bytes, geo_header_size);
+		}
+
+		file_close(file);
+	}
+
+	pigg_pack_write(out_file_name, items, item_count, options, temp_allocator);
+
+	return true;
+}
+
+// a trace is a text file listing paths one per line, in the order they're accessed
+const char** pigg_pack_trace_read(const char* trace_file_name, Linear_Allocator* allocator, int32* out_trace_count)
+{
+	File_Handle file = file_open_read(trace_file_name);
+	assert(file_is_valid(file));
+
+	uint32 size = (uint32)file_size(file);
+	char* text = (char*)linear_allocator_alloc(allocator, size + 1);
+	file_read(file, size, text);
+	text[size] = 0;
+	file_close(file);
+
+	int32 line_count = 0;
+	for (uint32 i = 0; i < size; ++i)
+	{
+		if (text[i] == '\n')
+		{
+			++line_count;
+		}
+	}
+	++line_count; // last line may not end in a newline
+
+	const char** trace = (const char**)linear_allocator_alloc(allocator, sizeof(const char*) * line_count);
+	int32 trace_count = 0;
+
+	char* line = text;
+	for (uint32 i = 0; i <= size; ++i)
+	{
+		if (text[i] == '\n' || text[i] == '\r' || text[i] == 0)
+		{
+			text[i] = 0;
+			if (*line)
+			{
+				trace[trace_count++] = line;
+			}
+			line = &text[i + 1];
+		}
+	}
+
+	*out_trace_count = trace_count;
+	return trace;
 }
\ No newline at end of file
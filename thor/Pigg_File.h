@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Core.h"
+#include "File.h"
+#include "Map.h"
 
 
 
@@ -8,6 +10,85 @@ constexpr uint32 c_pigg_file_sig = 0x123;
 constexpr uint32 c_internal_file_sig = 0x3456;
 constexpr uint32 c_string_table_sig = 0x6789;
 constexpr uint32 c_meta_table_sig = 0x9abc;
+constexpr uint32 c_invalid_id = (uint32)-1; // for string/slot ids
 
+// unpack_pigg_file flags
+constexpr uint32 c_unpack_incremental = 1 << 0; // skip entries whose timestamp and size match what was last unpacked
+constexpr uint32 c_unpack_compare_md5 = 1 << 1; // with c_unpack_incremental, also require the md5 to match
 
-void unpack_pigg_file(const char* file_name, struct Linear_Allocator* allocator);
\ No newline at end of file
+
+struct Pigg_Entry
+{
+	uint32 sig;
+	uint32 name_id;
+	uint32 file_size;
+	uint32 timestamp;
+	uint32 offset;
+	uint32 unknown;
+	uint32 header_id;
+	uint8 md5[16];
+	uint32 compressed_size;
+};
+
+// an open pigg, entry and name tables stay resident so internal files can be read on demand
+struct Pigg_Archive
+{
+	File_Handle file;
+	File_Mapping mapping; // only used if opened with pigg_open_mapped
+	uint64 size; // of the pigg file, entries are checked against this before being read
+	Pigg_Entry* entries;
+	uint32 entry_count;
+	const char** file_names;
+	uint32 file_name_count;
+	const uint8** headers; // raw file header table rows, see pigg_read_header
+	uint32* header_sizes;
+	uint32 header_count;
+	Map entry_map; // file name -> Pigg_Entry*
+};
+
+struct Pigg_Mount_File
+{
+	Pigg_Archive* archive;
+	Pigg_Entry* entry;
+};
+
+// every pigg in a directory tree mounted as one file system, where two piggs contain 
+// the same file, the one which sorts later by path wins
+struct Pigg_Mount
+{
+	Pigg_Archive* archives;
+	int32 archive_count;
+	Pigg_Mount_File* files;
+	int32 file_count;
+	Map file_map; // file name -> Pigg_Mount_File*
+};
+
+struct Pigg_Pack_Options
+{
+	const char** trace; // paths in the order they're accessed at runtime, these are written first and in this order
+	int32 trace_count;
+	uint32 alignment; // alignment in bytes of each entry's data, e.g. 4096 to start every entry on a page
+	int32 deflate_level; // c_zlib_deflate_level_*, for files packed from a directory, entries which don't get smaller are stored
+};
+
+
+bool32 pigg_open(Pigg_Archive* out_archive, const char* file_name, struct Linear_Allocator* allocator);
+bool32 pigg_open_mapped(Pigg_Archive* out_archive, const char* file_name, Linear_Allocator* allocator);
+void pigg_close(Pigg_Archive* archive);
+Pigg_Entry* pigg_find_entry(Pigg_Archive* archive, const char* path);
+const char* pigg_entry_name(Pigg_Archive* archive, Pigg_Entry* entry);
+uint8* pigg_read(Pigg_Archive* archive, Pigg_Entry* entry, Linear_Allocator* allocator);
+void pigg_read_batch(Pigg_Archive* archive, Pigg_Entry** entries, uint32 entry_count, File_Read_Queue* read_queue, struct Thread_Pool* thread_pool, Linear_Allocator* allocator, uint8** out_bytes);
+const uint8* pigg_read_mapped(Pigg_Archive* archive, Pigg_Entry* entry, Linear_Allocator* allocator);
+void pigg_prefetch(Pigg_Archive* archive, Pigg_Entry* entry, uint32 byte_count);
+uint8* pigg_read_header(Pigg_Archive* archive, Pigg_Entry* entry, Linear_Allocator* allocator, uint32* out_size);
+uint8* pigg_read(Pigg_Archive* archive, const char* path, Linear_Allocator* allocator, uint32* out_size);
+void pigg_mount_create(Pigg_Mount* out_mount, const char* piggs_path, Linear_Allocator* allocator, Linear_Allocator* temp_allocator);
+void pigg_mount_destroy(Pigg_Mount* mount);
+Pigg_Mount_File* pigg_mount_find(Pigg_Mount* mount, const char* path);
+uint8* pigg_mount_read(Pigg_Mount* mount, const char* path, Linear_Allocator* allocator, uint32* out_size);
+bool32 pigg_verify(Pigg_Archive* archive, struct Thread_Pool* thread_pool, File_Read_Queue* read_queue, Linear_Allocator* allocator, Pigg_Entry*** out_bad_entries, uint32* out_bad_entry_count);
+void pigg_pack_archive(const char* out_file_name, Pigg_Archive* source, Pigg_Pack_Options* options, Linear_Allocator* temp_allocator);
+bool32 pigg_pack_dir(const char* out_file_name, const char* dir_path, Pigg_Pack_Options* options, Thread_Pool* thread_pool, Linear_Allocator* temp_allocator);
+const char** pigg_pack_trace_read(const char* trace_file_name, Linear_Allocator* allocator, int32* out_trace_count);
+uint32 unpack_pigg_file(const char* file_name, uint32 flags, Thread_Pool* thread_pool, Linear_Allocator* allocator, uint32* out_failed_count);
\ No newline at end of file
@@ -48,6 +48,70 @@ bool string_equals_ignore_case(const char* a, const char* b)
 	return false;
 }
 
+// b doesn't need to be null terminated, e.g. it can be the start of a longer string
+bool string_equals_ignore_case(const char* a, const char* b, int32 b_char_count)
+{
+	for (int32 i = 0; i < b_char_count; ++i)
+	{
+		if (!a[i] || char_to_lower(a[i]) != char_to_lower(b[i]))
+		{
+			return false;
+		}
+	}
+
+	return !a[b_char_count];
+}
+
+// < 0 if a sorts before b, 0 if equal, > 0 if a sorts after b
+int32 string_compare_ignore_case(const char* a, const char* b)
+{
+	while (*a && char_to_lower(*a) == char_to_lower(*b))
+	{
+		++a;
+		++b;
+	}
+
+	return (int32)(uint8)char_to_lower(*a) - (int32)(uint8)char_to_lower(*b);
+}
+
+// pattern can use * for any run of characters and ? for any single character, e.g. "*.pigg"
+bool string_glob_match_ignore_case(const char* str, const char* pattern)
+{
+	// on a mismatch, go back to the last * and let it swallow one more character
+	const char* star = nullptr;
+	const char* star_str = nullptr;
+
+	while (*str)
+	{
+		if (*pattern == '*')
+		{
+			star = pattern++;
+			star_str = str;
+		}
+		else if (*pattern == '?' || (*pattern && char_to_lower(*pattern) == char_to_lower(*str)))
+		{
+			++pattern;
+			++str;
+		}
+		else if (star)
+		{
+			pattern = star + 1;
+			str = ++star_str;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	while (*pattern == '*')
+	{
+		++pattern;
+	}
+
+	return !*pattern;
+}
+
 bool string_starts_with(const char* str, const char* starts_with)
 {
 	while (*starts_with && *str == *starts_with)
@@ -246,9 +310,11 @@ static char* create_char_to_lower_table()
 
 static char* s_char_to_lower_table = create_char_to_lower_table();
 
-__forceinline char char_to_lower(char c)
+// not __forceinline, Map.cpp calls this and __forceinline also means inline, which would leave no 
+// definition for other files to link against
+char char_to_lower(char c)
 {
-	return s_char_to_lower_table[c];
+	return s_char_to_lower_table[(uint8)c]; // char is signed, names from files can have any byte in them
 }
 
 void string_to_lower(char* str)
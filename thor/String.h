@@ -7,9 +7,12 @@
 int32 string_length(const char* s);
 bool string_equals(const char* a, const char* b);
 bool string_equals_ignore_case(const char* a, const char* b);
+bool string_equals_ignore_case(const char* a, const char* b, int32 b_char_count);
+int32 string_compare_ignore_case(const char* a, const char* b);
 bool string_starts_with(const char* str, const char* starts_with);
 bool string_starts_with_ignore_case(const char* str, const char* starts_with);
 bool string_contains(const char* str, const char* contains);
+bool string_glob_match_ignore_case(const char* str, const char* pattern);
 int32 string_find(const char* str, char c);
 int32 string_find_last(const char* str, char c);
 int32 string_find_last(const char* str, char c, int32 start);
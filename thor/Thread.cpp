@@ -0,0 +1,407 @@
+#include "Thread.h"
+
+#if _WIN32
+#include <Windows.h>
+#else
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <unistd.h>
+#endif
+#include "Memory.h"
+
+
+
+#if _WIN32
+
+struct Thread_Start
+{
+	Thread_Function function;
+	void* state;
+};
+
+static DWORD WINAPI thread_start(LPVOID param)
+{
+	Thread_Start start = *(Thread_Start*)param;
+	delete (Thread_Start*)param;
+
+	start.function(start.state);
+
+	return 0;
+}
+
+Thread_Handle thread_create(Thread_Function function, void* state)
+{
+	Thread_Start* start = new Thread_Start;
+	start->function = function;
+	start->state = state;
+
+	HANDLE thread = CreateThread(/*lpThreadAttributes*/ nullptr, /*dwStackSize*/ 0, thread_start, start, /*dwCreationFlags*/ 0, /*lpThreadId*/ nullptr);
+	assert(thread);
+
+	return thread;
+}
+
+void thread_join(Thread_Handle thread)
+{
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+}
+
+int32 thread_get_processor_count()
+{
+	SYSTEM_INFO system_info;
+	GetSystemInfo(&system_info);
+
+	return (int32)system_info.dwNumberOfProcessors;
+}
+
+void thread_yield()
+{
+	SwitchToThread();
+}
+
+Semaphore_Handle semaphore_create(int32 initial_count)
+{
+	HANDLE semaphore = CreateSemaphoreA(/*lpSemaphoreAttributes*/ nullptr, initial_count, /*lMaximumCount*/ 0x7fffffff, /*lpName*/ nullptr);
+	assert(semaphore);
+
+	return semaphore;
+}
+
+void semaphore_destroy(Semaphore_Handle semaphore)
+{
+	CloseHandle(semaphore);
+}
+
+void semaphore_signal(Semaphore_Handle semaphore, int32 count)
+{
+	bool success = ReleaseSemaphore(semaphore, count, /*lpPreviousCount*/ nullptr);
+	assert(success);
+}
+
+void semaphore_wait(Semaphore_Handle semaphore)
+{
+	WaitForSingleObject(semaphore, INFINITE);
+}
+
+int32 atomic_increment(volatile int32* value)
+{
+	return InterlockedIncrement((volatile LONG*)value);
+}
+
+int32 atomic_decrement(volatile int32* value)
+{
+	return InterlockedDecrement((volatile LONG*)value);
+}
+
+int32 atomic_add(volatile int32* value, int32 amount)
+{
+	return InterlockedExchangeAdd((volatile LONG*)value, amount) + amount;
+}
+
+int64 atomic_exchange(volatile int64* value, int64 new_value)
+{
+	return InterlockedExchange64((volatile LONGLONG*)value, new_value);
+}
+
+bool atomic_compare_exchange(volatile int64* value, int64 new_value, int64 expected_value)
+{
+	return InterlockedCompareExchange64((volatile LONGLONG*)value, new_value, expected_value) == expected_value;
+}
+
+#else
+
+struct Thread_Start
+{
+	Thread_Function function;
+	void* state;
+};
+
+static void* thread_start(void* param)
+{
+	Thread_Start start = *(Thread_Start*)param;
+	delete (Thread_Start*)param;
+
+	start.function(start.state);
+
+	return nullptr;
+}
+
+// pthread_t isn't necessarily a pointer, so the handle points at a heap copy of it
+Thread_Handle thread_create(Thread_Function function, void* state)
+{
+	Thread_Start* start = new Thread_Start;
+	start->function = function;
+	start->state = state;
+
+	pthread_t* thread = new pthread_t;
+	int result = pthread_create(thread, /*attr*/ nullptr, thread_start, start);
+	assert(result == 0); result;
+
+	return thread;
+}
+
+void thread_join(Thread_Handle thread)
+{
+	pthread_join(*(pthread_t*)thread, /*retval*/ nullptr);
+	delete (pthread_t*)thread;
+}
+
+int32 thread_get_processor_count()
+{
+	return (int32)sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+void thread_yield()
+{
+	sched_yield();
+}
+
+Semaphore_Handle semaphore_create(int32 initial_count)
+{
+	sem_t* semaphore = new sem_t;
+	int result = sem_init(semaphore, /*pshared*/ 0, (unsigned int)initial_count);
+	assert(result == 0); result;
+
+	return semaphore;
+}
+
+void semaphore_destroy(Semaphore_Handle semaphore)
+{
+	sem_destroy((sem_t*)semaphore);
+	delete (sem_t*)semaphore;
+}
+
+void semaphore_signal(Semaphore_Handle semaphore, int32 count)
+{
+	for (int32 i = 0; i < count; ++i)
+	{
+		sem_post((sem_t*)semaphore);
+	}
+}
+
+void semaphore_wait(Semaphore_Handle semaphore)
+{
+	while (sem_wait((sem_t*)semaphore) != 0 && errno == EINTR)
+	{
+	}
+}
+
+int32 atomic_increment(volatile int32* value)
+{
+	return __atomic_add_fetch(value, 1, __ATOMIC_SEQ_CST);
+}
+
+int32 atomic_decrement(volatile int32* value)
+{
+	return __atomic_sub_fetch(value, 1, __ATOMIC_SEQ_CST);
+}
+
+int32 atomic_add(volatile int32* value, int32 amount)
+{
+	return __atomic_add_fetch(value, amount, __ATOMIC_SEQ_CST);
+}
+
+int64 atomic_exchange(volatile int64* value, int64 new_value)
+{
+	return __atomic_exchange_n(value, new_value, __ATOMIC_SEQ_CST);
+}
+
+bool atomic_compare_exchange(volatile int64* value, int64 new_value, int64 expected_value)
+{
+	return __atomic_compare_exchange_n(value, &expected_value, new_value, /*weak*/ false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+#endif // _WIN32
+
+static int64 thread_pool_range(uint32 begin, uint32 end)
+{
+	return (int64)(((uint64)end << 32) | begin);
+}
+
+static bool thread_pool_take_item(Thread_Pool::Worker* worker, uint32* out_item_index)
+{
+	while (true)
+	{
+		int64 range = worker->range;
+		uint32 begin = (uint32)range;
+		uint32 end = (uint32)((uint64)range >> 32);
+		if (begin >= end)
+		{
+			return false;
+		}
+
+		if (atomic_compare_exchange(&worker->range, thread_pool_range(begin + 1, end), range))
+		{
+			*out_item_index = begin;
+			return true;
+		}
+	}
+}
+
+// worker has run out of items, take the back half of someone else's
+static bool thread_pool_steal_items(Thread_Pool* thread_pool, int32 worker_index)
+{
+	for (int32 i = 1; i < thread_pool->worker_count; ++i)
+	{
+		Thread_Pool::Worker* victim = &thread_pool->workers[(worker_index + i) % thread_pool->worker_count];
+
+		while (true)
+		{
+			int64 range = victim->range;
+			uint32 begin = (uint32)range;
+			uint32 end = (uint32)((uint64)range >> 32);
+			if (begin >= end)
+			{
+				break;
+			}
+
+			uint32 steal_count = (end - begin + 1) / 2;
+			uint32 new_end = end - steal_count;
+			if (atomic_compare_exchange(&victim->range, thread_pool_range(begin, new_end), range))
+			{
+				atomic_exchange(&thread_pool->workers[worker_index].range, thread_pool_range(new_end, end));
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+static void thread_pool_do_work(Thread_Pool* thread_pool, int32 worker_index)
+{
+	Thread_Pool::Worker* worker = &thread_pool->workers[worker_index];
+
+	while (true)
+	{
+		uint32 item_index;
+		if (thread_pool_take_item(worker, &item_index))
+		{
+			thread_pool->job_function(item_index, worker_index, thread_pool->job_state);
+		}
+		else if (!thread_pool_steal_items(thread_pool, worker_index))
+		{
+			// items are never added during a run, so if there was nothing to steal then we're done
+			break;
+		}
+	}
+}
+
+struct Thread_Pool_Thread_State
+{
+	Thread_Pool* thread_pool;
+	int32 worker_index;
+};
+
+static void thread_pool_thread(void* state)
+{
+	Thread_Pool_Thread_State* thread_state = (Thread_Pool_Thread_State*)state;
+	Thread_Pool* thread_pool = thread_state->thread_pool;
+	int32 worker_index = thread_state->worker_index;
+
+	while (true)
+	{
+		semaphore_wait(thread_pool->start_semaphore);
+
+		if (thread_pool->is_shutting_down)
+		{
+			break;
+		}
+
+		thread_pool_do_work(thread_pool, worker_index);
+
+		if (atomic_decrement(&thread_pool->busy_thread_count) == 0)
+		{
+			semaphore_signal(thread_pool->done_semaphore, 1);
+		}
+	}
+}
+
+void thread_pool_create(Thread_Pool* out_thread_pool, int32 worker_count, Linear_Allocator* allocator)
+{
+	assert(worker_count > 0);
+
+	*out_thread_pool = {};
+	out_thread_pool->worker_count = worker_count;
+	out_thread_pool->workers = (Thread_Pool::Worker*)linear_allocator_alloc(allocator, sizeof(Thread_Pool::Worker) * worker_count);
+	out_thread_pool->start_semaphore = semaphore_create(0);
+	out_thread_pool->done_semaphore = semaphore_create(0);
+
+	for (int32 i = 0; i < worker_count; ++i)
+	{
+		out_thread_pool->workers[i].range = 0;
+	}
+
+	int32 thread_count = worker_count - 1;
+	if (thread_count)
+	{
+		out_thread_pool->threads = (Thread_Handle*)linear_allocator_alloc(allocator, sizeof(Thread_Handle) * thread_count);
+		Thread_Pool_Thread_State* thread_states = (Thread_Pool_Thread_State*)linear_allocator_alloc(allocator, sizeof(Thread_Pool_Thread_State) * thread_count);
+
+		for (int32 i = 0; i < thread_count; ++i)
+		{
+			thread_states[i].thread_pool = out_thread_pool;
+			thread_states[i].worker_index = i + 1;
+			out_thread_pool->threads[i] = thread_create(thread_pool_thread, &thread_states[i]);
+		}
+	}
+}
+
+void thread_pool_destroy(Thread_Pool* thread_pool)
+{
+	int32 thread_count = thread_pool->worker_count - 1;
+
+	thread_pool->is_shutting_down = 1;
+	if (thread_count)
+	{
+		semaphore_signal(thread_pool->start_semaphore, thread_count);
+	}
+
+	for (int32 i = 0; i < thread_count; ++i)
+	{
+		thread_join(thread_pool->threads[i]);
+	}
+
+	semaphore_destroy(thread_pool->start_semaphore);
+	semaphore_destroy(thread_pool->done_semaphore);
+
+	*thread_pool = {};
+}
+
+// blocks until job_function has been called for every item, items are dealt out to workers in 
+// contiguous runs so neighbouring items tend to be processed in order by the same thread
+void thread_pool_run(Thread_Pool* thread_pool, uint32 item_count, Thread_Pool_Job_Function job_function, void* job_state)
+{
+	if (!item_count)
+	{
+		return;
+	}
+
+	thread_pool->job_function = job_function;
+	thread_pool->job_state = job_state;
+
+	uint32 worker_count = (uint32)thread_pool->worker_count;
+	for (uint32 i = 0; i < worker_count; ++i)
+	{
+		uint32 begin = (uint32)(((uint64)item_count * i) / worker_count);
+		uint32 end = (uint32)(((uint64)item_count * (i + 1)) / worker_count);
+		atomic_exchange(&thread_pool->workers[i].range, thread_pool_range(begin, end));
+	}
+
+	int32 thread_count = thread_pool->worker_count - 1;
+	if (thread_count)
+	{
+		thread_pool->busy_thread_count = thread_count;
+		semaphore_signal(thread_pool->start_semaphore, thread_count);
+	}
+
+	thread_pool_do_work(thread_pool, /*worker_index*/ 0);
+
+	if (thread_count)
+	{
+		semaphore_wait(thread_pool->done_semaphore);
+	}
+}
\ No newline at end of file
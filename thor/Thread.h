@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Core.h"
+
+
+
+typedef void* Thread_Handle; // means that we don't have to include windows.h in this header
+typedef void* Semaphore_Handle;
+typedef void (*Thread_Function)(void* state);
+typedef void (*Thread_Pool_Job_Function)(uint32 item_index, int32 worker_index, void* state);
+
+
+// worker 0 is always the thread which calls thread_pool_run, the pool owns worker_count - 1 threads
+struct Thread_Pool
+{
+	struct Worker
+	{
+		volatile int64 range; // items this worker has left, begin in low 32 bits, end in high 32 bits
+		uint8 padding[56]; // keep each range on its own cache line
+	};
+
+	Thread_Handle* threads;
+	Worker* workers;
+	int32 worker_count;
+	Semaphore_Handle start_semaphore;
+	Semaphore_Handle done_semaphore;
+	volatile int32 busy_thread_count;
+	volatile int32 is_shutting_down;
+	Thread_Pool_Job_Function job_function;
+	void* job_state;
+};
+
+
+Thread_Handle thread_create(Thread_Function function, void* state);
+void thread_join(Thread_Handle thread);
+int32 thread_get_processor_count();
+void thread_yield();
+Semaphore_Handle semaphore_create(int32 initial_count);
+void semaphore_destroy(Semaphore_Handle semaphore);
+void semaphore_signal(Semaphore_Handle semaphore, int32 count);
+void semaphore_wait(Semaphore_Handle semaphore);
+int32 atomic_increment(volatile int32* value); // all atomic functions return the new value
+int32 atomic_decrement(volatile int32* value);
+int32 atomic_add(volatile int32* value, int32 amount);
+int64 atomic_exchange(volatile int64* value, int64 new_value); // returns the old value
+bool atomic_compare_exchange(volatile int64* value, int64 new_value, int64 expected_value);
+void thread_pool_create(Thread_Pool* out_thread_pool, int32 worker_count, struct Linear_Allocator* allocator);
+void thread_pool_destroy(Thread_Pool* thread_pool);
+void thread_pool_run(Thread_Pool* thread_pool, uint32 item_count, Thread_Pool_Job_Function job_function, void* job_state);
\ No newline at end of file
@@ -1,29 +1,277 @@
 #include "Zlib.h"
 
+#include "Deflate.h"
+#include "Fast_Inflate.h"
+#include "Memory.h"
+#include "Thread.h"
 #include "zlib/zlib.h"
 
 
 
-uint32 zlib_inflate_bytes(uint8* deflated_bytes, uint32 deflated_bytes_size, uint8* out_inflated_bytes, uint32 inflated_bytes_size)
+// set to 1 to inflate everything with zlib as well as fast_inflate_bytes and check they match
+#ifndef ZLIB_INFLATE_SELF_CHECK
+#define ZLIB_INFLATE_SELF_CHECK 0
+#endif
+
+
+// zlib's inflate state is ~7kb and its window 32kb, both allocated on first use and kept across resets
+constexpr uint32 c_zlib_inflate_context_memory_size = kilobytes(48);
+
+
+
+struct Zlib_Inflate_Batch_State
+{
+	Zlib_Inflate_Job* jobs;
+	Zlib_Inflate_Context* contexts; // one per worker
+};
+
+
+static voidpf zlib_inflate_context_alloc(voidpf opaque, uInt item_count, uInt item_size)
 {
-	z_stream zlib_stream;
-	zlib_stream.zalloc = Z_NULL;
-	zlib_stream.zfree = Z_NULL;
-	zlib_stream.opaque = Z_NULL;
-	zlib_stream.avail_in = 0;
-	zlib_stream.next_in = Z_NULL;
-	int zlib_result = inflateInit(&zlib_stream);
-	assert(zlib_result == Z_OK);
+	Zlib_Inflate_Context* context = (Zlib_Inflate_Context*)opaque;
 
-	zlib_stream.next_in = deflated_bytes;
-	zlib_stream.avail_in = deflated_bytes_size;
-	zlib_stream.next_out = out_inflated_bytes;
-	zlib_stream.avail_out = inflated_bytes_size;
-	zlib_result = inflate(&zlib_stream, Z_NO_FLUSH);
-	assert(zlib_result == Z_STREAM_END);
-	(void)inflateEnd(&zlib_stream);
+	uint32 size = (uint32)(item_count * item_size);
+	size = (size + 15) & ~15u;
+	if (size > context->memory_size - context->memory_used)
+	{
+		assert(false);
+		return Z_NULL;
+	}
+
+	uint8* bytes = &context->memory[context->memory_used];
+	context->memory_used += size;
+
+	return bytes;
+}
+
+static void zlib_inflate_context_free(voidpf opaque, voidpf address)
+{
+	// memory belongs to the allocator the context was created with
+	opaque;
+	address;
+}
+
+// how much zlib_inflate_context_create takes from its allocator
+uint32 zlib_inflate_context_size()
+{
+	return c_zlib_inflate_context_memory_size + (uint32)sizeof(z_stream);
+}
+
+void zlib_inflate_context_create(Zlib_Inflate_Context* out_context, Linear_Allocator* allocator)
+{
+	*out_context = {};
+	out_context->memory = linear_allocator_alloc(allocator, c_zlib_inflate_context_memory_size);
+	out_context->memory_size = c_zlib_inflate_context_memory_size;
 
-	assert(zlib_stream.avail_in == 0);
+	z_stream* zlib_stream = (z_stream*)linear_allocator_alloc(allocator, sizeof(z_stream));
+	*zlib_stream = {};
+	zlib_stream->zalloc = zlib_inflate_context_alloc;
+	zlib_stream->zfree = zlib_inflate_context_free;
+	zlib_stream->opaque = out_context;
+	int zlib_result = inflateInit(zlib_stream);
+	assert(zlib_result == Z_OK); zlib_result;
+
+	out_context->stream = zlib_stream;
+}
+
+// context is optional, without one zlib's state is set up and torn down for just this call
+static Zlib_Result zlib_inflate_bytes_with_zlib(Zlib_Inflate_Context* context, const uint8* deflated_bytes, uint32 deflated_bytes_size, uint8* out_inflated_bytes, uint32 inflated_bytes_size, uint32* out_bytes_inflated)
+{
+	*out_bytes_inflated = 0;
+
+	z_stream local_stream;
+	z_stream* zlib_stream;
+	int zlib_result;
+	if (context)
+	{
+		zlib_stream = context->stream;
+		zlib_result = inflateReset(zlib_stream);
+	}
+	else
+	{
+		zlib_stream = &local_stream;
+		zlib_stream->zalloc = Z_NULL;
+		zlib_stream->zfree = Z_NULL;
+		zlib_stream->opaque = Z_NULL;
+		zlib_stream->avail_in = 0;
+		zlib_stream->next_in = Z_NULL;
+		zlib_result = inflateInit(zlib_stream);
+	}
+
+	if (zlib_result != Z_OK)
+	{
+		return Zlib_Result::Corrupt;
+	}
+
+	zlib_stream->next_in = (Bytef*)deflated_bytes; // zlib doesn't write to the input, it just isn't const
+	zlib_stream->avail_in = deflated_bytes_size;
+	zlib_stream->next_out = out_inflated_bytes;
+	zlib_stream->avail_out = inflated_bytes_size;
+	zlib_result = inflate(zlib_stream, Z_NO_FLUSH);
+
+	if (!context)
+	{
+		(void)inflateEnd(zlib_stream);
+	}
+
+	*out_bytes_inflated = inflated_bytes_size - zlib_stream->avail_out;
+
+	// anything other than reaching the end means bad data, or data which inflates to more than inflated_bytes_size
+	return zlib_result == Z_STREAM_END ? Zlib_Result::Ok : Zlib_Result::Corrupt;
+}
+
+// whole buffer inflate, tries fast_inflate_bytes first and only falls back to zlib if that fails, which for 
+// valid data it shouldn't. Context is optional, it's only used if zlib is needed
+static Zlib_Result zlib_inflate_bytes_internal(Zlib_Inflate_Context* context, const uint8* deflated_bytes, uint32 deflated_bytes_size, uint8* out_inflated_bytes, uint32 inflated_bytes_size, uint32* out_bytes_inflated)
+{
+	if (!fast_inflate_bytes(deflated_bytes, deflated_bytes_size, out_inflated_bytes, inflated_bytes_size, out_bytes_inflated))
+	{
+		return zlib_inflate_bytes_with_zlib(context, deflated_bytes, deflated_bytes_size, out_inflated_bytes, inflated_bytes_size, out_bytes_inflated);
+	}
+
+#if ZLIB_INFLATE_SELF_CHECK
+	// no allocator is passed in this far down, so the check makes its own just for this call
+	Linear_Allocator check_allocator;
+	linear_allocator_create(&check_allocator, inflated_bytes_size ? inflated_bytes_size : 1);
+	uint8* check_bytes = linear_allocator_alloc(&check_allocator, check_allocator.size);
+	uint32 check_bytes_inflated;
+	Zlib_Result check_result = zlib_inflate_bytes_with_zlib(context, deflated_bytes, deflated_bytes_size, check_bytes, inflated_bytes_size, &check_bytes_inflated);
+	assert(check_result == Zlib_Result::Ok && check_bytes_inflated == *out_bytes_inflated);
+	check_result;
+	assert(bytes_equal(check_bytes, out_inflated_bytes, check_bytes_inflated));
+	linear_allocator_destroy(&check_allocator);
+#endif // ZLIB_INFLATE_SELF_CHECK
+
+	return Zlib_Result::Ok;
+}
+
+uint32 zlib_inflate_bytes(const uint8* deflated_bytes, uint32 deflated_bytes_size, uint8* out_inflated_bytes, uint32 inflated_bytes_size)
+{
+	return zlib_inflate_bytes(nullptr, deflated_bytes, deflated_bytes_size, out_inflated_bytes, inflated_bytes_size);
+}
 
-	return inflated_bytes_size - zlib_stream.avail_out;
+// for data which is trusted, returns the number of bytes inflated
+uint32 zlib_inflate_bytes(Zlib_Inflate_Context* context, const uint8* deflated_bytes, uint32 deflated_bytes_size, uint8* out_inflated_bytes, uint32 inflated_bytes_size)
+{
+	uint32 bytes_inflated;
+	Zlib_Result result = zlib_inflate_bytes_internal(context, deflated_bytes, deflated_bytes_size, out_inflated_bytes, inflated_bytes_size, &bytes_inflated);
+	assert(result == Zlib_Result::Ok); result;
+
+	return bytes_inflated;
+}
+
+// for data which might be corrupt, succeeds only if the data is valid and inflates to exactly inflated_bytes_size, 
+// nothing is ever written past out_inflated_bytes + inflated_bytes_size
+Zlib_Result zlib_inflate_bytes_checked(Zlib_Inflate_Context* context, const uint8* deflated_bytes, uint32 deflated_bytes_size, uint8* out_inflated_bytes, uint32 inflated_bytes_size)
+{
+	uint32 bytes_inflated;
+	Zlib_Result result = zlib_inflate_bytes_internal(context, deflated_bytes, deflated_bytes_size, out_inflated_bytes, inflated_bytes_size, &bytes_inflated);
+	if (result == Zlib_Result::Ok && bytes_inflated != inflated_bytes_size)
+	{
+		return Zlib_Result::Wrong_Size;
+	}
+
+	return result;
+}
+
+static void zlib_inflate_batch_job(uint32 item_index, int32 worker_index, void* state)
+{
+	Zlib_Inflate_Batch_State* batch_state = (Zlib_Inflate_Batch_State*)state;
+	Zlib_Inflate_Job* job = &batch_state->jobs[item_index];
+
+	job->result = zlib_inflate_bytes_checked(&batch_state->contexts[worker_index], job->deflated_bytes, job->deflated_bytes_size, job->out_inflated_bytes, job->inflated_bytes_size);
+}
+
+// inflates lots of (typically small) buffers spread across the thread pool, each worker has its own context. 
+// thread_pool is optional, without one everything is inflated on the calling thread. Contexts are taken from 
+// temp_allocator and handed back before returning. Returns the number of jobs which didn't succeed
+uint32 zlib_inflate_batch(Zlib_Inflate_Job* jobs, uint32 job_count, Thread_Pool* thread_pool, Linear_Allocator* temp_allocator)
+{
+	if (!job_count)
+	{
+		return 0;
+	}
+
+	int32 worker_count = thread_pool ? thread_pool->worker_count : 1;
+
+	Linear_Allocator context_allocator = *temp_allocator;
+
+	Zlib_Inflate_Batch_State batch_state = {};
+	batch_state.jobs = jobs;
+	batch_state.contexts = (Zlib_Inflate_Context*)linear_allocator_alloc(&context_allocator, sizeof(Zlib_Inflate_Context) * worker_count);
+	for (int32 i = 0; i < worker_count; ++i)
+	{
+		zlib_inflate_context_create(&batch_state.contexts[i], &context_allocator);
+	}
+
+	if (thread_pool)
+	{
+		thread_pool_run(thread_pool, job_count, zlib_inflate_batch_job, &batch_state);
+	}
+	else
+	{
+		for (uint32 i = 0; i < job_count; ++i)
+		{
+			zlib_inflate_batch_job(i, /*worker_index*/ 0, &batch_state);
+		}
+	}
+
+	uint32 failed_count = 0;
+	for (uint32 i = 0; i < job_count; ++i)
+	{
+		if (jobs[i].result != Zlib_Result::Ok)
+		{
+			++failed_count;
+		}
+	}
+
+	return failed_count;
+}
+
+// most bytes zlib_deflate_bytes can write for bytes_size bytes of input
+uint32 zlib_deflate_bound(uint32 bytes_size)
+{
+	return deflate_bound(bytes_size);
+}
+
+// the vendored zlib is inflate only, so this uses our own compressor, output is a normal zlib stream. Returns 
+// the deflated size, or 0 if out_deflated_bytes_capacity is less than needed (zlib_deflate_bound is always enough)
+uint32 zlib_deflate_bytes(const uint8* bytes, uint32 bytes_size, int32 level, uint8* out_deflated_bytes, uint32 out_deflated_bytes_capacity, Linear_Allocator* temp_allocator)
+{
+	return deflate_bytes(bytes, bytes_size, level, out_deflated_bytes, out_deflated_bytes_capacity, temp_allocator);
+}
+
+// the stream uses the context's zlib state, so the context can't be used for anything else until the stream ends
+void zlib_inflate_stream_begin(Zlib_Inflate_Stream* out_stream, Zlib_Inflate_Context* context)
+{
+	int zlib_result = inflateReset(context->stream);
+	assert(zlib_result == Z_OK); zlib_result;
+
+	out_stream->stream = context->stream;
+}
+
+// inflates as much as will fit in out_inflated_bytes, out_bytes_inflated is the number of bytes written there, 
+// out_is_finished is set once the end of the deflated data has been reached
+Zlib_Result zlib_inflate_stream(Zlib_Inflate_Stream* stream, const uint8* deflated_bytes, uint32 deflated_bytes_size, uint32* out_deflated_bytes_consumed, uint8* out_inflated_bytes, uint32 out_inflated_bytes_capacity, uint32* out_bytes_inflated, bool32* out_is_finished)
+{
+	z_stream* zlib_stream = stream->stream;
+	zlib_stream->next_in = (Bytef*)deflated_bytes;
+	zlib_stream->avail_in = deflated_bytes_size;
+	zlib_stream->next_out = out_inflated_bytes;
+	zlib_stream->avail_out = out_inflated_bytes_capacity;
+
+	int zlib_result = inflate(zlib_stream, Z_NO_FLUSH);
+
+	*out_deflated_bytes_consumed = deflated_bytes_size - zlib_stream->avail_in;
+	*out_bytes_inflated = out_inflated_bytes_capacity - zlib_stream->avail_out;
+	*out_is_finished = zlib_result == Z_STREAM_END;
+
+	// buf error just means no progress could be made
+	return zlib_result == Z_OK || zlib_result == Z_STREAM_END || zlib_result == Z_BUF_ERROR ? Zlib_Result::Ok : Zlib_Result::Corrupt;
+}
+
+void zlib_inflate_stream_end(Zlib_Inflate_Stream* stream)
+{
+	// nothing to tear down, the zlib state stays with the context to be reset next time
+	stream->stream = nullptr;
 }
\ No newline at end of file
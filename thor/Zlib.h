@@ -4,4 +4,56 @@
 
 
 
-uint32 zlib_inflate_bytes(uint8* deflated_bytes, uint32 deflated_bytes_size, uint8* out_inflated_bytes, uint32 inflated_bytes_size);
\ No newline at end of file
+// deflate levels, anything 0-9 works the same as zlib
+constexpr int32 c_zlib_deflate_level_store = 0;
+constexpr int32 c_zlib_deflate_level_fastest = 1; // for when write throughput matters more than size
+constexpr int32 c_zlib_deflate_level_default = 6;
+constexpr int32 c_zlib_deflate_level_best = 9;
+
+
+enum class Zlib_Result
+{
+	Ok,
+	Corrupt, // not valid zlib data, the checksum doesn't match, or it inflates to more than there's room for
+	Wrong_Size // valid, but inflated to less than expected
+};
+
+
+// zlib state which is reset for each use rather than set up and torn down every time, all of its memory is 
+// taken from the allocator up front so there's nothing to free
+struct Zlib_Inflate_Context
+{
+	struct z_stream_s* stream;
+	uint8* memory; // zlib's internal state and window are allocated from here
+	uint32 memory_size;
+	uint32 memory_used;
+};
+
+// one buffer for zlib_inflate_batch, result is filled in when the batch is done
+struct Zlib_Inflate_Job
+{
+	const uint8* deflated_bytes;
+	uint32 deflated_bytes_size;
+	uint8* out_inflated_bytes;
+	uint32 inflated_bytes_size;
+	Zlib_Result result;
+};
+
+// for inflating data a chunk at a time, when it's too big (or too unknown) to do all at once
+struct Zlib_Inflate_Stream
+{
+	struct z_stream_s* stream;
+};
+
+
+uint32 zlib_inflate_context_size();
+void zlib_inflate_context_create(Zlib_Inflate_Context* out_context, struct Linear_Allocator* allocator);
+uint32 zlib_inflate_bytes(const uint8* deflated_bytes, uint32 deflated_bytes_size, uint8* out_inflated_bytes, uint32 inflated_bytes_size);
+uint32 zlib_inflate_bytes(Zlib_Inflate_Context* context, const uint8* deflated_bytes, uint32 deflated_bytes_size, uint8* out_inflated_bytes, uint32 inflated_bytes_size);
+Zlib_Result zlib_inflate_bytes_checked(Zlib_Inflate_Context* context, const uint8* deflated_bytes, uint32 deflated_bytes_size, uint8* out_inflated_bytes, uint32 inflated_bytes_size);
+uint32 zlib_inflate_batch(Zlib_Inflate_Job* jobs, uint32 job_count, struct Thread_Pool* thread_pool, Linear_Allocator* temp_allocator);
+uint32 zlib_deflate_bound(uint32 bytes_size);
+uint32 zlib_deflate_bytes(const uint8* bytes, uint32 bytes_size, int32 level, uint8* out_deflated_bytes, uint32 out_deflated_bytes_capacity, Linear_Allocator* temp_allocator);
+void zlib_inflate_stream_begin(Zlib_Inflate_Stream* out_stream, Zlib_Inflate_Context* context);
+Zlib_Result zlib_inflate_stream(Zlib_Inflate_Stream* stream, const uint8* deflated_bytes, uint32 deflated_bytes_size, uint32* out_deflated_bytes_consumed, uint8* out_inflated_bytes, uint32 out_inflated_bytes_capacity, uint32* out_bytes_inflated, bool32* out_is_finished);
+void zlib_inflate_stream_end(Zlib_Inflate_Stream* stream);
\ No newline at end of file